@@ -0,0 +1,603 @@
+//------------------------------------------------------------------------------
+// batch_kmd.hpp
+//
+// Copyright (C) 2025 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - BatchLoader for loading many kmd model blocks from many files in one call
+//   - io_uring backend on Linux that submits block reads in batches into registered buffers
+//   - positional read thread pool fallback where io_uring is unavailable
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <span>
+#include <memory>
+
+#include "import_kmd.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+	#define KALA_KMD_IO_URING 1
+	#include <linux/io_uring.h>
+	#include <sys/syscall.h>
+	#include <sys/uio.h>
+#endif
+
+namespace KalaHeaders::KalaModelData
+{
+	using std::atomic_ref;
+	using std::memory_order_acquire;
+	using std::memory_order_release;
+	using std::unique_ptr;
+	using std::make_unique;
+	
+	//One model block to load, fileIndex is returned by BatchLoader::AddFile
+	struct BlockRequest
+	{
+		u32 fileIndex{};
+		u32 modelIndex{};
+	};
+	
+	//Loads sets of model blocks from any number of open kmd files. On Linux all reads of a set
+	//are queued to io_uring in batches of queueDepth reads, landing in registered staging buffers
+	//when the block fits a slot, elsewhere the reads are spread over a positional read thread pool
+	class BatchLoader
+	{
+	public:
+		BatchLoader() = default;
+		~BatchLoader() { Close(); }
+		
+		BatchLoader(const BatchLoader&) = delete;
+		BatchLoader& operator=(const BatchLoader&) = delete;
+		
+		//Sets up the io_uring backend with queueDepth reads in flight and slotSize bytes of registered
+		//buffer per read, queueDepth 0 always uses the fallback. threadCount is only used by the fallback,
+		//0 uses one per hardware thread
+		void Open(
+			u32 queueDepth = 32,
+			u32 slotSize = 131072u,
+			u32 threadCount = 0)
+		{
+			Close();
+			
+			fallbackThreadCount = threadCount == 0
+				? max(thread::hardware_concurrency(), 1u)
+				: threadCount;
+				
+#ifdef KALA_KMD_IO_URING
+			if (queueDepth > 0)
+			{
+				isUsingIoUring = ring.Open(
+					queueDepth,
+					slotSize);
+			}
+#else
+			(void)queueDepth;
+			(void)slotSize;
+#endif
+		}
+		
+		void Close()
+		{
+			files.clear();
+			
+#ifdef KALA_KMD_IO_URING
+			ring.Close();
+#endif
+			isUsingIoUring = false;
+		}
+		
+		//True if block reads go through io_uring instead of the thread pool fallback
+		bool IsUsingIoUring() const { return isUsingIoUring; }
+		
+		//Validates the file, loads its tables and keeps one handle open for block reads,
+		//mode picks how the blocks of this file are verified when they are loaded
+		ImportResult AddFile(
+			const path& inFile,
+			u32& outFileIndex,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			auto reader = make_unique<KmdReader>();
+			
+			ImportResult openResult = reader->Open(inFile, mode);
+			if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+			
+			outFileIndex = scast<u32>(files.size());
+			files.push_back(move(reader));
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		const vector<ModelTable>& GetTables(u32 fileIndex) const { return files[fileIndex]->GetTables(); }
+		
+		//Loads every requested block, outBlocks[i] is the block of requests[i].
+		//Returns the first error in request order and leaves outBlocks untouched on failure
+		ImportResult LoadBlocks(
+			span<const BlockRequest> requests,
+			vector<ModelBlock>& outBlocks)
+		{
+			vector<ReadTarget> targets(requests.size());
+			
+			for (size_t i = 0; i < requests.size(); i++)
+			{
+				const BlockRequest& r = requests[i];
+				if (r.fileIndex >= files.size()
+					|| r.modelIndex >= files[r.fileIndex]->GetTables().size())
+				{
+					return ImportResult::RESULT_INVALID_MODEL_COUNT;
+				}
+				
+				const KmdReader& f = *files[r.fileIndex];
+				const ModelTable& t = f.GetTables()[r.modelIndex];
+				
+				//verify that block size is not OOB
+				if (!IsInsideRegion(t.blockOffset, t.blockSize, 0, f.GetFileSize())) return ImportResult::RESULT_UNEXPECTED_EOF;
+				
+				targets[i] = {
+					f.GetNativeFile(),
+					t.blockOffset,
+					t.blockSize,
+					f.GetValidationMode(),
+					FindBlockChecksum(f.GetChecksums(), t.blockOffset) };
+			}
+			
+			try
+			{
+				vector<ModelBlock> blocks(requests.size());
+				vector<ImportResult> results(requests.size(), ImportResult::RESULT_SUCCESS);
+				
+#ifdef KALA_KMD_IO_URING
+				//a ring that failed mid-load is closed, later loads use the fallback
+				if (isUsingIoUring) isUsingIoUring = ring.Load(targets, blocks, results);
+				else LoadWithThreads(targets, blocks, results);
+#else
+				LoadWithThreads(targets, blocks, results);
+#endif
+				
+				for (ImportResult result : results)
+				{
+					if (result != ImportResult::RESULT_SUCCESS) return result;
+				}
+				
+				outBlocks = move(blocks);
+				
+				return ImportResult::RESULT_SUCCESS;
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+		}
+	
+	private:
+		struct ReadTarget
+		{
+			NativeFile file{};
+			u64 offset{};
+			u32 size{};
+			
+			ValidationMode mode{};
+			const u32* checksum{}; //stored checksum of the block or nullptr
+		};
+		
+		vector<unique_ptr<KmdReader>> files{};
+		u32 fallbackThreadCount = 1;
+		bool isUsingIoUring{};
+		
+		//Spreads the reads over the fallback threads, each thread reuses one buffer for all its blocks
+		void LoadWithThreads(
+			const vector<ReadTarget>& targets,
+			vector<ModelBlock>& blocks,
+			vector<ImportResult>& results) const
+		{
+			atomic<size_t> nextTarget{};
+			
+			auto work = [&]()
+				{
+					vector<u8> buffer{};
+					
+					for (size_t i = nextTarget++; i < targets.size(); i = nextTarget++)
+					{
+						const ReadTarget& t = targets[i];
+						
+						try
+						{
+							if (buffer.size() < t.size) buffer.resize(t.size);
+							
+							results[i] = ReadFileAt(
+								t.file,
+								t.offset,
+								t.size,
+								buffer.data());
+							
+							if (results[i] == ImportResult::RESULT_SUCCESS)
+							{
+								results[i] = ParseBlock(
+									buffer.data(),
+									t.size,
+									blocks[i],
+									t.mode,
+									t.checksum);
+							}
+						}
+						catch (...)
+						{
+							results[i] = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+						}
+					}
+				};
+			
+			size_t threadCount = min(scast<size_t>(fallbackThreadCount), targets.size());
+			
+			//the calling thread is one of the workers
+			vector<thread> threads{};
+			for (size_t i = 1; i < threadCount; i++) threads.emplace_back(work);
+			
+			work();
+			
+			for (auto& t : threads) t.join();
+		}
+		
+#ifdef KALA_KMD_IO_URING
+		//Minimal io_uring wrapper over the raw syscalls, so no liburing is needed
+		class Ring
+		{
+		public:
+			~Ring() { Close(); }
+			
+			bool Open(
+				u32 queueDepth,
+				u32 newSlotSize)
+			{
+				io_uring_params params{};
+				
+				ringFd = scast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+				if (ringFd < 0) return false;
+				
+				sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+				cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				
+				bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (isSingleMmap) sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+				
+				sqRing = MapRing(sqRingSize, IORING_OFF_SQ_RING);
+				cqRing = isSingleMmap ? sqRing : MapRing(cqRingSize, IORING_OFF_CQ_RING);
+				
+				sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				void* mappedSqes = MapRing(sqesSize, IORING_OFF_SQES);
+				
+				if (!sqRing
+					|| !cqRing
+					|| !mappedSqes)
+				{
+					if (mappedSqes) munmap(mappedSqes, sqesSize);
+					Close();
+					return false;
+				}
+				
+				u8* sq = scast<u8*>(sqRing);
+				u8* cq = scast<u8*>(cqRing);
+				
+				sqTail = rcast<u32*>(sq + params.sq_off.tail);
+				sqMask = *rcast<u32*>(sq + params.sq_off.ring_mask);
+				sqArray = rcast<u32*>(sq + params.sq_off.array);
+				sqes = scast<io_uring_sqe*>(mappedSqes);
+				
+				cqHead = rcast<u32*>(cq + params.cq_off.head);
+				cqTail = rcast<u32*>(cq + params.cq_off.tail);
+				cqMask = *rcast<u32*>(cq + params.cq_off.ring_mask);
+				cqes = rcast<io_uring_cqe*>(cq + params.cq_off.cqes);
+				
+				slotCount = params.sq_entries;
+				slotSize = newSlotSize;
+				
+				//fixed buffers need locked memory, without them the reads go to per-slot heap buffers
+				stagingSize = scast<size_t>(slotCount) * slotSize;
+				void* mappedStaging = mmap(
+					nullptr,
+					stagingSize,
+					PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS,
+					-1,
+					0);
+				
+				if (mappedStaging != MAP_FAILED)
+				{
+					staging = scast<u8*>(mappedStaging);
+					
+					vector<iovec> buffers(slotCount);
+					for (u32 i = 0; i < slotCount; i++) buffers[i] = { staging + scast<size_t>(i) * slotSize, slotSize };
+					
+					hasFixedBuffers = syscall(
+						__NR_io_uring_register,
+						ringFd,
+						IORING_REGISTER_BUFFERS,
+						buffers.data(),
+						slotCount) == 0;
+				}
+				
+				slots.resize(slotCount);
+				
+				return true;
+			}
+			
+			void Close()
+			{
+				if (staging) munmap(staging, stagingSize);
+				if (sqes) munmap(sqes, sqesSize);
+				if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+				if (sqRing) munmap(sqRing, sqRingSize);
+				if (ringFd >= 0) close(ringFd);
+				
+				staging = nullptr;
+				sqes = nullptr;
+				cqRing = nullptr;
+				sqRing = nullptr;
+				ringFd = -1;
+				hasFixedBuffers = false;
+				
+				slots.clear();
+			}
+			
+			//Keeps up to slotCount reads in flight, parsing each block as soon as its read completes.
+			//Returns false if the ring stopped accepting reads, it is closed by then
+			bool Load(
+				const vector<ReadTarget>& targets,
+				vector<ModelBlock>& blocks,
+				vector<ImportResult>& results)
+			{
+				vector<u32> freeSlots{};
+				for (u32 i = slotCount; i > 0; i--) freeSlots.push_back(i - 1);
+				
+				size_t nextTarget{};
+				size_t finishedCount{};
+				u32 queuedCount{};
+				
+				while (finishedCount < targets.size())
+				{
+					while (nextTarget < targets.size()
+						&& !freeSlots.empty())
+					{
+						u32 slotIndex = freeSlots.back();
+						freeSlots.pop_back();
+						
+						Slot& s = slots[slotIndex];
+						s.target = nextTarget++;
+						s.done = 0;
+						s.isActive = true;
+						
+						const ReadTarget& t = targets[s.target];
+						s.isFixed = hasFixedBuffers && t.size <= slotSize;
+						if (!s.isFixed && s.large.size() < t.size) s.large.resize(t.size);
+						
+						QueueRead(slotIndex, t);
+						queuedCount++;
+					}
+					
+					if (!Submit(queuedCount))
+					{
+						//the ring stopped accepting reads, every read that did not finish fails
+						u32 activeCount{};
+						for (const auto& s : slots)
+						{
+							if (!s.isActive) continue;
+							
+							results[s.target] = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+							activeCount++;
+						}
+						for (size_t i = nextTarget; i < targets.size(); i++) results[i] = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+						
+						//the kernel may still write into the slot buffers, and the reads it did not take
+						//would be submitted by the next load, so the ring is only closed once they landed
+						Drain(activeCount - min(queuedCount, activeCount));
+						Close();
+						
+						return false;
+					}
+					
+					u32 head = *cqHead;
+					u32 tail = atomic_ref<u32>(*cqTail).load(memory_order_acquire);
+					
+					for (; head != tail; head++)
+					{
+						const io_uring_cqe& cqe = cqes[head & cqMask];
+						u32 slotIndex = scast<u32>(cqe.user_data);
+						Slot& s = slots[slotIndex];
+						const ReadTarget& t = targets[s.target];
+						
+						if (cqe.res < 0)
+						{
+							results[s.target] = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+						}
+						else if (cqe.res == 0)
+						{
+							results[s.target] = ImportResult::RESULT_UNEXPECTED_EOF;
+						}
+						else
+						{
+							s.done += scast<u32>(cqe.res);
+							
+							//short reads are continued from where they stopped
+							if (s.done < t.size)
+							{
+								QueueRead(slotIndex, t);
+								queuedCount++;
+								continue;
+							}
+							
+							try
+							{
+								results[s.target] = ParseBlock(
+									SlotData(slotIndex),
+									t.size,
+									blocks[s.target],
+									t.mode,
+									t.checksum);
+							}
+							catch (...)
+							{
+								results[s.target] = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+							}
+						}
+						
+						s.isActive = false;
+						freeSlots.push_back(slotIndex);
+						finishedCount++;
+					}
+					
+					atomic_ref<u32>(*cqHead).store(head, memory_order_release);
+				}
+				
+				return true;
+			}
+		
+		private:
+			struct Slot
+			{
+				size_t target{};
+				u32 done{};
+				bool isFixed{};
+				bool isActive{};
+				vector<u8> large{};
+			};
+			
+			int ringFd = -1;
+			
+			void* sqRing{};
+			void* cqRing{};
+			size_t sqRingSize{};
+			size_t cqRingSize{};
+			size_t sqesSize{};
+			
+			u32* sqTail{};
+			u32 sqMask{};
+			u32* sqArray{};
+			io_uring_sqe* sqes{};
+			
+			u32* cqHead{};
+			u32* cqTail{};
+			u32 cqMask{};
+			io_uring_cqe* cqes{};
+			
+			u8* staging{};
+			size_t stagingSize{};
+			u32 slotCount{};
+			u32 slotSize{};
+			bool hasFixedBuffers{};
+			
+			vector<Slot> slots{};
+			
+			void* MapRing(
+				size_t size,
+				u64 offset) const
+			{
+				void* mapped = mmap(
+					nullptr,
+					size,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE,
+					ringFd,
+					scast<off_t>(offset));
+				
+				return mapped == MAP_FAILED ? nullptr : mapped;
+			}
+			
+			u8* SlotData(u32 slotIndex)
+			{
+				return slots[slotIndex].isFixed
+					? staging + scast<size_t>(slotIndex) * slotSize
+					: slots[slotIndex].large.data();
+			}
+			
+			//Fills the next submission entry with the remaining bytes of the slot's read
+			void QueueRead(
+				u32 slotIndex,
+				const ReadTarget& t)
+			{
+				Slot& s = slots[slotIndex];
+				
+				u32 tail = *sqTail;
+				u32 index = tail & sqMask;
+				
+				io_uring_sqe& sqe = sqes[index];
+				sqe = {};
+				sqe.opcode = s.isFixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+				sqe.fd = t.file;
+				sqe.off = scast<u64>(t.offset) + s.done;
+				sqe.addr = rcast<uintptr_t>(SlotData(slotIndex) + s.done);
+				sqe.len = t.size - s.done;
+				sqe.user_data = slotIndex;
+				if (s.isFixed) sqe.buf_index = scast<u16>(slotIndex);
+				
+				sqArray[index] = index;
+				
+				atomic_ref<u32>(*sqTail).store(tail + 1, memory_order_release);
+			}
+			
+			//Submits the queued reads and waits until at least one read has completed,
+			//queuedCount is left with the reads the kernel did not take yet
+			bool Submit(u32& queuedCount)
+			{
+				while (true)
+				{
+					int result = scast<int>(syscall(
+						__NR_io_uring_enter,
+						ringFd,
+						queuedCount,
+						1,
+						IORING_ENTER_GETEVENTS,
+						nullptr,
+						0));
+					
+					if (result >= 0)
+					{
+						queuedCount -= min(scast<u32>(result), queuedCount);
+						return true;
+					}
+					if (errno != EINTR) return false;
+				}
+			}
+			
+			//Waits for inFlight completions and drops them, stops early if the ring can't be waited on
+			void Drain(u32 inFlight)
+			{
+				while (inFlight > 0)
+				{
+					u32 head = *cqHead;
+					u32 tail = atomic_ref<u32>(*cqTail).load(memory_order_acquire);
+					
+					u32 ready = min(tail - head, inFlight);
+					inFlight -= ready;
+					
+					atomic_ref<u32>(*cqHead).store(head + ready, memory_order_release);
+					
+					if (inFlight == 0) return;
+					
+					int result = scast<int>(syscall(
+						__NR_io_uring_enter,
+						ringFd,
+						0,
+						1,
+						IORING_ENTER_GETEVENTS,
+						nullptr,
+						0));
+					
+					if (result < 0
+						&& errno != EINTR)
+					{
+						return;
+					}
+				}
+			}
+		};
+		
+		Ring ring{};
+#endif
+	};
+}
\ No newline at end of file
@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------------
+// cache_kmd.hpp
+//
+// Copyright (C) 2025 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - BlockCache for sharing loaded kmd model blocks between any number of consumers
+//   - memory budget with least recently used eviction of blocks nobody holds
+//   - CacheStats with hit rate, evictions and resident bytes
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "import_kmd.hpp"
+
+namespace KalaHeaders::KalaModelData
+{
+	using std::list;
+	using std::unordered_map;
+	using std::shared_ptr;
+	using std::make_shared;
+	using std::unique_ptr;
+	using std::make_unique;
+	using std::mutex;
+	using std::scoped_lock;
+	
+	//Shared read-only block, the block stays resident for as long as any handle to it exists
+	using BlockHandle = shared_ptr<const ModelBlock>;
+	
+	//Counters of a BlockCache since it was created
+	struct CacheStats
+	{
+		u64 hitCount{};      //acquires served from resident blocks
+		u64 missCount{};     //acquires that had to read the block
+		u64 evictionCount{}; //blocks dropped to stay within the budget
+		
+		u64 residentCount{}; //blocks currently in memory
+		u64 residentBytes{}; //bytes of all resident blocks
+		u64 budgetBytes{};   //configured memory budget
+		
+		f64 hitRate{}; //hitCount / (hitCount + missCount)
+	};
+	
+	//Loads model blocks once per (file, block) and hands out shared handles to them.
+	//Blocks that no handle refers to anymore stay resident until the budget is exceeded,
+	//then they are evicted least recently used first. Blocks that are still held are never
+	//evicted, so the budget can be exceeded while consumers hold more than it allows
+	class BlockCache
+	{
+	public:
+		explicit BlockCache(u64 newBudgetBytes) : budgetBytes(newBudgetBytes) {}
+		
+		BlockCache(const BlockCache&) = delete;
+		BlockCache& operator=(const BlockCache&) = delete;
+		
+		//Opens the file once and returns its file index, adding the same file again returns
+		//the index it already has. mode picks how the blocks of this file are verified when they are read
+		ImportResult AddFile(
+			const path& inFile,
+			u32& outFileIndex,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			string key{};
+			try
+			{
+				key = weakly_canonical(inFile).string();
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_FILE_NOT_FOUND;
+			}
+			
+			scoped_lock lock(cacheMutex);
+			
+			auto it = fileIndexes.find(key);
+			if (it != fileIndexes.end())
+			{
+				outFileIndex = it->second;
+				return ImportResult::RESULT_SUCCESS;
+			}
+			
+			auto reader = make_unique<KmdReader>();
+			
+			ImportResult openResult = reader->Open(inFile, mode);
+			if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+			
+			outFileIndex = scast<u32>(files.size());
+			files.push_back(move(reader));
+			fileIndexes[key] = outFileIndex;
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Reader of an added file for its tables and name lookups, valid for the lifetime of the cache
+		const KmdReader& GetFile(u32 fileIndex) const
+		{
+			scoped_lock lock(cacheMutex);
+			return *files[fileIndex];
+		}
+		
+		//Returns a shared handle to the block, reading it only if it is not resident yet
+		ImportResult Acquire(
+			u32 fileIndex,
+			u32 modelIndex,
+			BlockHandle& outBlock)
+		{
+			u64 key = (scast<u64>(fileIndex) << 32) | modelIndex;
+			
+			const KmdReader* reader{};
+			
+			{
+				scoped_lock lock(cacheMutex);
+				
+				if (fileIndex >= files.size()) return ImportResult::RESULT_INVALID_MODEL_COUNT;
+				
+				reader = files[fileIndex].get();
+				
+				if (modelIndex >= reader->GetTables().size()) return ImportResult::RESULT_INVALID_MODEL_COUNT;
+				
+				auto it = entries.find(key);
+				if (it != entries.end())
+				{
+					//most recently used blocks are kept at the front
+					recency.splice(recency.begin(), recency, it->second);
+					
+					stats.hitCount++;
+					outBlock = it->second->block;
+					
+					return ImportResult::RESULT_SUCCESS;
+				}
+			}
+			
+			//the read runs unlocked so other consumers are not stalled by it
+			auto block = make_shared<ModelBlock>();
+			
+			ImportResult readResult = reader->ReadBlock(
+				reader->GetTables()[modelIndex],
+				*block);
+			
+			if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+			
+			scoped_lock lock(cacheMutex);
+			
+			stats.missCount++;
+			
+			//another consumer may have loaded the same block meanwhile, keep only one copy
+			auto it = entries.find(key);
+			if (it != entries.end())
+			{
+				recency.splice(recency.begin(), recency, it->second);
+				outBlock = it->second->block;
+				
+				return ImportResult::RESULT_SUCCESS;
+			}
+			
+			Entry e{};
+			e.key = key;
+			e.bytes = GetBlockBytes(*block);
+			e.block = move(block);
+			
+			recency.push_front(move(e));
+			entries[key] = recency.begin();
+			
+			stats.residentBytes += recency.front().bytes;
+			
+			outBlock = recency.front().block;
+			
+			EvictUnlocked();
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Evicts released blocks until the cache fits its budget again,
+		//call after dropping many handles to free their memory right away
+		void Trim()
+		{
+			scoped_lock lock(cacheMutex);
+			EvictUnlocked();
+		}
+		
+		void SetBudget(u64 newBudgetBytes)
+		{
+			scoped_lock lock(cacheMutex);
+			
+			budgetBytes = newBudgetBytes;
+			EvictUnlocked();
+		}
+		
+		CacheStats GetStats() const
+		{
+			scoped_lock lock(cacheMutex);
+			
+			CacheStats s = stats;
+			s.residentCount = entries.size();
+			s.budgetBytes = budgetBytes;
+			
+			u64 acquireCount = s.hitCount + s.missCount;
+			if (acquireCount > 0) s.hitRate = scast<f64>(s.hitCount) / scast<f64>(acquireCount);
+			
+			return s;
+		}
+	
+	private:
+		struct Entry
+		{
+			u64 key{};
+			u64 bytes{};
+			shared_ptr<ModelBlock> block{};
+		};
+		
+		mutable mutex cacheMutex{};
+		
+		vector<unique_ptr<KmdReader>> files{};
+		unordered_map<string, u32> fileIndexes{};
+		
+		list<Entry> recency{};
+		unordered_map<u64, list<Entry>::iterator> entries{};
+		
+		u64 budgetBytes{};
+		CacheStats stats{};
+		
+		static u64 GetBlockBytes(const ModelBlock& block)
+		{
+			return sizeof(ModelBlock)
+				+ block.vertices.capacity() * sizeof(Vertex)
+				+ block.indices.capacity() * sizeof(u32);
+		}
+		
+		//Walks from the least recently used block, new handles to a block only come from
+		//Acquire under cacheMutex so a use count of one means only the cache still holds it
+		void EvictUnlocked()
+		{
+			auto it = recency.end();
+			while (stats.residentBytes > budgetBytes
+				&& it != recency.begin())
+			{
+				--it;
+				
+				if (it->block.use_count() != 1) continue;
+				
+				stats.residentBytes -= it->bytes;
+				stats.evictionCount++;
+				
+				entries.erase(it->key);
+				it = recency.erase(it);
+			}
+		}
+	};
+}
\ No newline at end of file
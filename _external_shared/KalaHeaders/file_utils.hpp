@@ -23,6 +23,7 @@
 #include <filesystem>
 #include <cerrno>
 #include <cstring>
+#include <cstdio>
 
 //reinterpret_cast
 #ifndef rcast
@@ -75,10 +76,28 @@ namespace KalaHeaders::KalaFile
 	using u8 = uint8_t;
 	using u16 = uint16_t;
 	using u32 = uint32_t;
+	using u64 = uint64_t;
 	using i8 = int8_t;
 	using i16 = int16_t;
 	using i32 = int32_t;
 
+	//Copies the message of errno value err to buf, returns false if it could not be resolved
+	inline bool ErrnoToString(
+		int err,
+		char* buf,
+		size_t bufSize)
+	{
+#ifdef _WIN32
+		return strerror_s(buf, bufSize, err) == 0;
+#else
+		const char* message = strerror(err);
+		if (message == nullptr) return false;
+
+		snprintf(buf, bufSize, "%s", message);
+		return true;
+#endif
+	}
+
 	enum class FileType
 	{
 		FILE_TEXT,
@@ -857,7 +876,7 @@ namespace KalaHeaders::KalaFile
 					<< "' line count because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1028,7 +1047,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1100,7 +1119,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1201,7 +1220,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1280,7 +1299,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1460,7 +1479,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1480,7 +1499,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1555,7 +1574,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1630,7 +1649,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -1779,6 +1798,23 @@ namespace KalaHeaders::KalaFile
 		data[offset + 2] = scast<u8>((value >> 16) & 0xFF);
 		data[offset + 3] = scast<u8>((value >> 24) & 0xFF);
 	}
+	inline void WriteU64(
+		vector<u8>& data,
+		size_t offset,
+		u64 value)
+	{
+		//append data to the end of the file
+		if (offset == scast<size_t>(-1))
+		{
+			for (size_t i = 0; i < 8; i++) data.push_back(scast<u8>((value >> (i * 8)) & 0xFF));
+			return;
+		}
+		
+		//write at target offset, auto-resize if needed
+		if (offset + 7 >= data.size()) data.resize(offset + 8);
+		
+		for (size_t i = 0; i < 8; i++) data[offset + i] = scast<u8>((value >> (i * 8)) & 0xFF);
+	}
 	
 	inline u8 ReadU8(
 		const vector<u8>& data,
@@ -1808,7 +1844,18 @@ namespace KalaHeaders::KalaFile
 			| scast<u32>(data[offset + 2]) << 16
 			| scast<u32>(data[offset + 3]) << 24;
 	}
-	
+	inline u64 ReadU64(
+		const vector<u8>& data,
+		size_t offset)
+	{
+		if (offset + 7 >= data.size()) return 0;
+		
+		u64 value{};
+		for (size_t i = 0; i < 8; i++) value |= scast<u64>(data[offset + i]) << (i * 8);
+		
+		return value;
+	}
+
 	inline void WriteI8(
 		vector<u8>& data,
 		size_t offset,
@@ -1964,7 +2011,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -2035,7 +2082,7 @@ namespace KalaHeaders::KalaFile
 						<< "' because it couldn't be opened! "
 						<< "Reason: (errno " << err << "): ";
 
-					if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+					if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 					else oss << " Unknown error";
 
 					return oss.str();
@@ -2140,7 +2187,7 @@ namespace KalaHeaders::KalaFile
 					<< "' because it couldn't be opened! "
 					<< "Reason: (errno " << err << "): ";
 
-				if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+				if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 				else oss << " Unknown error";
 
 				return oss.str();
@@ -2211,7 +2258,7 @@ namespace KalaHeaders::KalaFile
 						<< "' because it couldn't be opened! "
 						<< "Reason: (errno " << err << "): ";
 
-					if (strerror_s(buf, sizeof(buf), err) == 0) oss << buf;
+					if (ErrnoToString(err, buf, sizeof(buf))) oss << buf;
 					else oss << " Unknown error";
 
 					return oss.str();
@@ -8,6 +8,17 @@
 //
 // Provides:
 //   - Helpers for streaming individual models or loading the full kalamodeldata binary into memory
+//   - Version 1 and version 2 (64-bit offsets and sizes, no 1024 model limit) file support
+//   - KmdFile for reading the header, tables and any models through one open file handle
+//   - KmdReader for reading models from any number of threads through one shared OS file handle
+//   - MappedKMD for memory-mapping a kalamodeldata binary and viewing its models without copies
+//   - FindModel for looking up models by node name through the optional name index section
+//   - CRC32C block checksums with trusted and paranoid validation modes
+//   - MergeBlocks for copying models into caller-owned vertex, index and indirect draw buffers
+//   - PmrModelBlock overloads for importing all geometry of a file from one caller-provided memory resource
+//   - LoadTelemetry for per-phase load timings and counters, compiled out unless KALA_KMD_TELEMETRY is defined
+//   - StreamModelsAs for decoding vertices straight into an engine vertex layout described at compile time
+//   - GetLoaderPool, the ThreadPool shared by every loader that parses or validates blocks on several threads
 //------------------------------------------------------------------------------
 
 /*------------------------------------------------------------------------------
@@ -34,7 +45,7 @@ Downscale multiplier values:
 	7 - 0.001f
 	8 - 0.0001f
 	9-255 - unused, defaults to 0
-
+	
 # KMD binary model table
 
 Offset | Size | Field
@@ -43,8 +54,35 @@ Offset | Size | Field
 ??+20  | 4    | model block offset from start
 ??+24  | 4    | size of the model payload (block data size)
 
+# KMD binary version 2
+
+Version 2 lifts the model count and size limits of version 1 for very large scenes, only the
+top header and model tables are wider. Model blocks and trailing sections are the same in both
+versions and exporters keep writing version 1 for every file that fits its limits.
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+0      | 4    | KMD magic word, always 'K', 'M', 'D', '\0'
+4      | 1    | kmd binary version, always 2
+5      | 1    | global model-space scale factor
+6      | 4    | total model count (table and block per model)
+10     | 8    | combined size of all model tables
+18     | 8    | combined size of all model data blocks
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+??     | 20   | fixed-length name of the model (19 characters + null terminator)
+??+20  | 8    | model block offset from start
+??+28  | 8    | size of the model payload (block data size)
+
+Model blocks keep their 32-bit vertices and indices sizes, so a single block stays below 4 GB.
+
 # KMD binary model block
 
+Exporters pad the start of the first model block to a multiple of 4 bytes with
+0-3 zero bytes counted in the model blocks size, all blocks are multiples of 4 bytes
+so every vertex and index array can be read in place from an aligned file mapping.
+
 Offset | Size | Field
 -------|------|--------------------------------------------
 ??     | 20   | fixed-length name of the model node (19 characters + null terminator)
@@ -69,22 +107,83 @@ Data types:
 	3 - has light data,
 	4 - has animation data (animations, bones, curves)
 	5-7 - unused
-	
+
 Render type:
 	0 - opaque
 	1 - transparent (assigned if material is enabled, material has transparent texture or color)
 	2 - masked (assigned if material is enabled, material has transparent texture or color but alpha/transparency is 100% or 0%)
 	3-255 - unused, defaults to 0
+	
+# KMD binary trailing sections
+
+Optional sections may follow the model blocks, importers skip sections they don't know
+and files without any trailing sections stay valid.
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+??     | 4    | section tag
+??+4   | 4    | section payload size
+??+8   | ???  | section payload
+
+Name index section ('N', 'I', 'D', 'X'), one entry per model sorted by hash and then by model index:
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+??     | 4    | FNV-1a hash of the model table node name
+??+4   | 4    | model index in the model table
+
+Checksum section ('C', 'R', 'C', 'S'), one entry per model in model table order:
+
+Offset | Size | Field
+-------|------|--------------------------------------------
+??     | 4    | CRC32C of all bytes of the model block
 
 ------------------------------------------------------------------------------*/
 
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <string>
+#include <cstring>
+#include <cerrno>
 #include <fstream>
 #include <filesystem>
+#include <span>
+#include <string_view>
+#include <bit>
+#include <concepts>
+#include <type_traits>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+
+#include "thread_utils.hpp"
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+//CRC32C uses the hardware instructions when the target is built with them
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64)) \
+	|| defined(_M_X64) && defined(__AVX__)
+	#include <nmmintrin.h>
+	#define KALA_KMD_CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+	#include <arm_acle.h>
+	#define KALA_KMD_CRC32C_ARM
+#endif
 
 //reinterpret_cast
 #ifndef rcast
@@ -101,6 +200,8 @@ namespace KalaHeaders::KalaModelData
 	using std::vector;
 	using std::array;
 	using std::string;
+	using std::string_view;
+	using std::span;
 	using std::ifstream;
 	using std::filesystem::path;
 	using std::filesystem::current_path;
@@ -113,36 +214,102 @@ namespace KalaHeaders::KalaModelData
 	using std::streamsize;
 	using std::ios;
 	using std::move;
+	using std::min;
+	using std::bit_cast;
+	using std::is_trivially_copyable_v;
+	using std::is_default_constructible_v;
+	using std::pmr::memory_resource;
+	using std::thread;
+	using std::atomic;
+	using std::max;
+	using std::iota;
+	using std::stable_sort;
+	using std::chrono::steady_clock;
+	using std::chrono::duration;
+	using std::chrono::nanoseconds;
+	using std::chrono::duration_cast;
+	using std::to_string;
+	
+	using KalaHeaders::KalaThread::ThreadPool;
+	using KalaHeaders::KalaThread::TaskGroup;
 	
 	using u8 = uint8_t;
 	using u16 = uint16_t;
+	using i8 = int8_t;
+	using i16 = int16_t;
 	using u32 = uint32_t;
+	using i32 = int32_t;
+	using u64 = uint64_t;
 	using f32 = float;
+	using f64 = double;
 	
 	//The magic that must exist in all kmd files at the first four bytes
 	constexpr u32 KMD_MAGIC = 0x00444D4B;
 	
-	//The version that must exist in all kmd files as the fifth byte
+	//The version of files with 32-bit offsets and sizes, written by exporters whenever a file fits its limits
 	constexpr u8 KMD_VERSION = 1;
 	
-	//The true top header size that is always required
+	//The version of files with 64-bit offsets and sizes and no model count or total size limits
+	constexpr u8 KMD_VERSION_2 = 2;
+	
+	//The true top header size of version 1 files
 	constexpr u8 CORRECT_MODEL_HEADER_SIZE = 18u;
 	
-	//The true per-model table size that is always required
+	//The true per-model table size of version 1 files
 	constexpr u8 CORRECT_MODEL_TABLE_SIZE = 28u;
 	
+	//The true top header size of version 2 files
+	constexpr u8 CORRECT_MODEL_HEADER_SIZE_V2 = 26u;
+	
+	//The true per-model table size of version 2 files
+	constexpr u8 CORRECT_MODEL_TABLE_SIZE_V2 = 36u;
+	
 	//The offset where vertice data must always start relative to each model block
 	constexpr u8 VERTICE_DATA_OFFSET = 148u;
 	
-	//Max allowed models
+	//Exporters align the first model block to this many bytes
+	constexpr u8 MODEL_BLOCK_ALIGNMENT = 4u;
+	
+	//Tag of the optional name index section, always 'N', 'I', 'D', 'X'
+	constexpr u32 NAME_INDEX_TAG = 0x5844494E;
+	
+	//Size of the tag and payload size in front of every trailing section
+	constexpr u8 SECTION_HEADER_SIZE = 8u;
+	
+	//Size of one name index entry (name hash + model index)
+	constexpr u8 NAME_INDEX_ENTRY_SIZE = 8u;
+	
+	//Tag of the optional checksum section, always 'C', 'R', 'C', 'S'
+	constexpr u32 CHECKSUM_TAG = 0x53435243;
+	
+	//Max allowed models in version 1 files
 	constexpr u16 MAX_MODEL_COUNT = 1024u;
 	
-	//Max allowed total model table size in bytes (28 KB)
+	//Max allowed total model table size of version 1 files in bytes (28 KB)
 	constexpr u32 MAX_MODEL_TABLE_SIZE = 28672u;
 	
-	//Max allowed total model blocks size in bytes (1 GB)
+	//Max allowed total model blocks size of version 1 files in bytes (1 GB)
 	constexpr u32 MAX_MODEL_BLOCK_SIZE = 1073741824u;
 	
+	//Max allowed size of a single model block in version 2 files, the vertices
+	//and indices sizes inside every block are still 32-bit (4 GB - 1)
+	constexpr u32 MAX_SINGLE_BLOCK_SIZE = 0xFFFFFFFFu;
+	
+	//Max allowed combined size of all trailing sections in bytes (64 KB),
+	//importers also allow the name index and checksum entries of every model on top of it
+	constexpr u32 MAX_TRAILING_SIZE = 65536u;
+	
+	//Blocks whose gap to the previous requested block is at most this many bytes are read
+	//together by KmdFile::ReadBlocks, the gap bytes are read and thrown away (64 KB)
+	constexpr u32 DEFAULT_MAX_READ_GAP = 65536u;
+	
+	//KmdFile::ReadBlocks never merges blocks into a read larger than this, a single
+	//block larger than this is still read at once (8 MB)
+	constexpr u32 MAX_COALESCED_READ_SIZE = 8388608u;
+	
+	//ImportKMD starts one parse thread per this many bytes of model blocks (1 MB)
+	constexpr u32 MIN_PARSE_BYTES_PER_THREAD = 1048576u;
+	
 	//Not allowed to be less than this position in X, Y or Z axis
 	constexpr f32 MIN_POS = -10000.0f;
 	//Not allowed to be more than this position in X, Y or Z axis
@@ -163,12 +330,36 @@ namespace KalaHeaders::KalaModelData
 		+ CORRECT_MODEL_TABLE_SIZE
 		+ VERTICE_DATA_OFFSET;
 	
-	//Max allowed size for kmd files
+	//Max allowed size for version 1 kmd files, version 2 files are only limited by their header
 	constexpr u32 MAX_TOTAL_SIZE = 
 		CORRECT_MODEL_HEADER_SIZE 
 		+ MAX_MODEL_TABLE_SIZE 
-		+ MAX_MODEL_BLOCK_SIZE;
+		+ MAX_MODEL_BLOCK_SIZE
+		+ MAX_TRAILING_SIZE;
+	
+	//Returns the top header size of a file of this version
+	constexpr size_t GetHeaderSize(u8 version)
+	{
+		return version == KMD_VERSION_2
+			? CORRECT_MODEL_HEADER_SIZE_V2
+			: CORRECT_MODEL_HEADER_SIZE;
+	}
+	
+	//Returns the per-model table size of a file of this version
+	constexpr size_t GetTableSize(u8 version)
+	{
+		return version == KMD_VERSION_2
+			? CORRECT_MODEL_TABLE_SIZE_V2
+			: CORRECT_MODEL_TABLE_SIZE;
+	}
 	
+	//Returns how many trailing bytes importers read for a file with modelCount models,
+	//enough for the name index and checksum entries of every model next to MAX_TRAILING_SIZE
+	constexpr size_t GetMaxTrailingSize(u32 modelCount)
+	{
+		return MAX_TRAILING_SIZE + scast<size_t>(modelCount) * (NAME_INDEX_ENTRY_SIZE + sizeof(u32));
+	}
+
 	//The main header at the top of each kmd file
 	struct ModelHeader
 	{
@@ -176,15 +367,15 @@ namespace KalaHeaders::KalaModelData
 		u8 version = KMD_VERSION; //kmd binary version
 		u8 scaleFactor{};         //global model-space scale factor
 		u32 modelCount{};         //count of models
-		u32 modelTablesSize{};    //total size of model tables
-		u32 modelBlocksSize{};    //total size of model data blocks
+		u64 modelTablesSize{};    //total size of model tables
+		u64 modelBlocksSize{};    //total size of model data blocks
 	};
-
+	
 	//The table that helps look up models individually
 	struct ModelTable
 	{
 		char nodeName[20]{}; //19 chars + null terminator
-		u32 blockOffset{};   //absolute offset from start of file
+		u64 blockOffset{};   //absolute offset from start of file
 		u32 blockSize{};     //size of the model data block
 	};
 	
@@ -196,9 +387,11 @@ namespace KalaHeaders::KalaModelData
 		f32 texCoord[2]{}; //u, v
 		f32 tangent[4]{};  //tx, ty, tz, tw
 	};
-		
-	//The block containing data of each model
-	struct ModelBlock
+	
+	//The block containing data of each model, VertexVector and IndexVector
+	//pick the containers and allocator the vertices and indices are stored with
+	template <typename VertexVector, typename IndexVector>
+	struct BasicModelBlock
 	{
 		char nodeName[20]{}; //19 chars + null terminator
 		char meshName[20]{}; //19 chars + null terminator
@@ -215,10 +408,16 @@ namespace KalaHeaders::KalaModelData
 		u32 indicesOffset{};
 		u32 indicesSize{};
 		
-		vector<Vertex> vertices{};
-		vector<u32> indices{};
+		VertexVector vertices{};
+		IndexVector indices{};
 	};
 	
+	using ModelBlock = BasicModelBlock<vector<Vertex>, vector<u32>>;
+	
+	//Model block whose vertices and indices are allocated from a memory resource, a
+	//monotonic_buffer_resource of modelBlocksSize bytes holds the geometry of every block in the file
+	using PmrModelBlock = BasicModelBlock<std::pmr::vector<Vertex>, std::pmr::vector<u32>>;
+	
 	enum class ImportResult : u8
 	{
 		RESULT_SUCCESS                     = 0, //No errors, succeeded with import
@@ -250,7 +449,27 @@ namespace KalaHeaders::KalaModelData
 		RESULT_INVALID_MODEL_SIZE          = 15, //model size must be within range
 		RESULT_INVALID_MODEL_TABLE_SIZE    = 16, //found a model table that wasnt the correct size
 		RESULT_INVALID_MODEL_BLOCK_SIZE    = 17, //found a model block that was less or more than the allowed size
-		RESULT_UNEXPECTED_EOF              = 18  //file reached end sooner than expected
+		RESULT_UNEXPECTED_EOF              = 18, //file reached end sooner than expected
+		
+		//
+		// STREAMING
+		//
+		
+		RESULT_CANCELLED                   = 19, //streaming request was cancelled before it was read
+		RESULT_BUFFER_TOO_SMALL            = 20, //caller-provided buffer can't fit the requested data
+		
+		//
+		// INTEGRITY
+		//
+		
+		RESULT_CHECKSUM_MISMATCH           = 21, //model block bytes don't match their stored checksum
+		RESULT_INVALID_VERTEX_DATA         = 22, //found a NaN or Inf vertex value or an index past the last vertex
+		
+		//
+		// MERGING
+		//
+		
+		RESULT_MERGE_TOO_LARGE             = 23  //merged models need more indices or vertices than a draw command can offset
 	};
 	
 	inline string ResultToString(ImportResult result)
@@ -258,7 +477,7 @@ namespace KalaHeaders::KalaModelData
 		switch (result)
 		{
 		default: return "RESULT_UNKNOWN";
-			
+		
 		case ImportResult::RESULT_SUCCESS:
 			return "RESULT_SUCCESS";
 		
@@ -274,10 +493,10 @@ namespace KalaHeaders::KalaModelData
 			return "RESULT_UNKNOWN_READ_ERROR";
 		case ImportResult::RESULT_FILE_EMPTY:
 			return "RESULT_FILE_EMPTY";
-			
+		
 		case ImportResult::RESULT_UNSUPPORTED_FILE_SIZE:
 			return "RESULT_UNSUPPORTED_FILE_SIZE";
-			
+		
 		case ImportResult::RESULT_INVALID_MAGIC:
 			return "RESULT_INVALID_MAGIC";
 		case ImportResult::RESULT_INVALID_VERSION:
@@ -300,11 +519,186 @@ namespace KalaHeaders::KalaModelData
 			return "RESULT_INVALID_MODEL_BLOCK_SIZE";
 		case ImportResult::RESULT_UNEXPECTED_EOF:
 			return "RESULT_UNEXPECTED_EOF";
-		}
+		
+		case ImportResult::RESULT_CANCELLED:
+			return "RESULT_CANCELLED";
+		case ImportResult::RESULT_BUFFER_TOO_SMALL:
+			return "RESULT_BUFFER_TOO_SMALL";
+		
+		case ImportResult::RESULT_CHECKSUM_MISMATCH:
+			return "RESULT_CHECKSUM_MISMATCH";
+		case ImportResult::RESULT_INVALID_VERTEX_DATA:
+			return "RESULT_INVALID_VERTEX_DATA";
+		
+		case ImportResult::RESULT_MERGE_TOO_LARGE:
+			return "RESULT_MERGE_TOO_LARGE";
+}
 		
 		return "RESULT_UNKNOWN";
 	}
 	
+	//
+	// TELEMETRY
+	//
+	
+	//Define KALA_KMD_TELEMETRY before including this header to record load telemetry,
+	//without it every telemetry hook in the importers compiles to nothing
+#ifdef KALA_KMD_TELEMETRY
+	constexpr bool IS_TELEMETRY_ENABLED = true;
+#else
+	constexpr bool IS_TELEMETRY_ENABLED = false;
+#endif
+	
+	enum class LoadPhase : u8
+	{
+		PHASE_OPEN        = 0, //opening or mapping the file and querying its size
+		PHASE_HEADER      = 1, //reading and validating the top header
+		PHASE_TABLES      = 2, //parsing the model tables and the name index
+		PHASE_BLOCK_IO    = 3, //reading model blocks
+		PHASE_BLOCK_PARSE = 4, //validating and copying model blocks
+		
+		PHASE_COUNT       = 5
+	};
+	
+	inline string PhaseToString(LoadPhase phase)
+	{
+		switch (phase)
+		{
+		default: return "unknown";
+		
+		case LoadPhase::PHASE_OPEN:        return "open";
+		case LoadPhase::PHASE_HEADER:      return "header";
+		case LoadPhase::PHASE_TABLES:      return "tables";
+		case LoadPhase::PHASE_BLOCK_IO:    return "blockIO";
+		case LoadPhase::PHASE_BLOCK_PARSE: return "blockParse";
+		}
+	}
+	
+	//Counters and timings of every import made on a thread while a TelemetryScope over it
+	//was active, stays zero unless KALA_KMD_TELEMETRY is defined
+	struct LoadTelemetry
+	{
+		u64 openCount{};       //files opened or mapped
+		u64 syscallCount{};    //file read calls, each pread or ReadFile retry counts once
+		u64 bytesRead{};       //bytes read from files, mapped files read none
+		u64 blocksDecoded{};   //model blocks validated and copied or viewed
+		u64 allocationCount{}; //vertex, index and read buffer allocations made by the importers
+		u64 allocationBytes{}; //bytes of those allocations
+		
+		array<u64, scast<size_t>(LoadPhase::PHASE_COUNT)> phaseNanoseconds{};
+		
+		//Adds the counters and timings of other, for aggregating calls, threads or files
+		void Add(const LoadTelemetry& other)
+		{
+			openCount += other.openCount;
+			syscallCount += other.syscallCount;
+			bytesRead += other.bytesRead;
+			blocksDecoded += other.blocksDecoded;
+			allocationCount += other.allocationCount;
+			allocationBytes += other.allocationBytes;
+			
+			for (size_t i = 0; i < phaseNanoseconds.size(); i++) phaseNanoseconds[i] += other.phaseNanoseconds[i];
+		}
+		
+		string ToJSON() const
+		{
+			string json = "{"
+				"\"openCount\":" + to_string(openCount)
+				+ ",\"syscallCount\":" + to_string(syscallCount)
+				+ ",\"bytesRead\":" + to_string(bytesRead)
+				+ ",\"blocksDecoded\":" + to_string(blocksDecoded)
+				+ ",\"allocationCount\":" + to_string(allocationCount)
+				+ ",\"allocationBytes\":" + to_string(allocationBytes)
+				+ ",\"phaseNanoseconds\":{";
+			
+			for (size_t i = 0; i < phaseNanoseconds.size(); i++)
+			{
+				if (i > 0) json += ",";
+				json += "\"" + PhaseToString(scast<LoadPhase>(i)) + "\":" + to_string(phaseNanoseconds[i]);
+			}
+			
+			return json + "}}";
+		}
+	};
+	
+#ifdef KALA_KMD_TELEMETRY
+	//Telemetry the importers on this thread currently record into, nullptr records nothing
+	inline LoadTelemetry*& GetTelemetrySink()
+	{
+		thread_local LoadTelemetry* sink{};
+		return sink;
+	}
+	
+	//Records every import made on this thread into telemetry until the scope ends,
+	//scopes nest and the innermost one receives the records
+	class TelemetryScope
+	{
+	public:
+		explicit TelemetryScope(LoadTelemetry& telemetry) : previous(GetTelemetrySink())
+		{
+			GetTelemetrySink() = &telemetry;
+		}
+		~TelemetryScope() { GetTelemetrySink() = previous; }
+		
+		TelemetryScope(const TelemetryScope&) = delete;
+		TelemetryScope& operator=(const TelemetryScope&) = delete;
+	
+	private:
+		LoadTelemetry* previous{};
+	};
+	
+	//Adds value to a counter of the telemetry this thread records into
+	inline void AddTelemetry(
+		u64 LoadTelemetry::* counter,
+		u64 value)
+	{
+		if (LoadTelemetry* t = GetTelemetrySink()) t->*counter += value;
+	}
+	
+	//Adds the time from construction to destruction to a phase of the telemetry this thread records into
+	class PhaseTimer
+	{
+	public:
+		explicit PhaseTimer(LoadPhase newPhase) : sink(GetTelemetrySink()), phase(newPhase)
+		{
+			if (sink) start = steady_clock::now();
+		}
+		~PhaseTimer()
+		{
+			if (!sink) return;
+			
+			sink->phaseNanoseconds[scast<size_t>(phase)] += scast<u64>(
+				duration_cast<nanoseconds>(steady_clock::now() - start).count());
+		}
+		
+		PhaseTimer(const PhaseTimer&) = delete;
+		PhaseTimer& operator=(const PhaseTimer&) = delete;
+	
+	private:
+		LoadTelemetry* sink{};
+		LoadPhase phase{};
+		steady_clock::time_point start{};
+	};
+#else
+	inline LoadTelemetry* GetTelemetrySink() { return nullptr; }
+	
+	class TelemetryScope
+	{
+	public:
+		explicit TelemetryScope(LoadTelemetry&) {}
+	};
+	
+	inline void AddTelemetry(
+		u64 LoadTelemetry::*,
+		u64) {}
+	
+	class PhaseTimer
+	{
+	public:
+		explicit PhaseTimer(LoadPhase) {}
+	};
+#endif
+	
 	inline ImportResult PreReadCheck(const path& inFile)
 	{
 		if (!exists(inFile)) return ImportResult::RESULT_FILE_NOT_FOUND;
@@ -349,14 +743,11 @@ namespace KalaHeaders::KalaModelData
 			size_t fileSize = scast<size_t>(in.tellg());
 			
 			if (fileSize == 0) return ImportResult::RESULT_FILE_EMPTY;
+			//the max size depends on the version, it is checked once the header is parsed
 			if (fileSize < MIN_TOTAL_SIZE)
 			{
 				return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
 			}
-			if (fileSize > MAX_TOTAL_SIZE)
-			{
-				return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
-			}
 			
 			in.close();
 			
@@ -368,475 +759,2920 @@ namespace KalaHeaders::KalaModelData
 		}
 	}
 	
-	//Returns header data of the file,
-	//set skipChecks to true if the file has already been checked
-	inline ImportResult GetHeaderData(
-		const path& inFile,
-		ModelHeader& outHeader,
-		bool skipChecks = false)
+	//Parses and validates the top header of a version 1 or version 2 file,
+	//data must hold at least CORRECT_MODEL_HEADER_SIZE_V2 bytes
+	inline ImportResult ParseHeader(
+		const u8* data,
+		ModelHeader& outHeader)
 	{
-		if (!skipChecks)
-		{
-			ImportResult preReadResult = PreReadCheck(inFile);
-			if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+		ModelHeader header{};
+		
+		//model header
+		
+		memcpy(&header.magic, data + 0, sizeof(u32));
+		if (header.magic != KMD_MAGIC) return ImportResult::RESULT_INVALID_MAGIC;
 		
-			ImportResult tryOpenResult = TryOpenCheck(inFile);
-			if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+		memcpy(&header.version, data + 4, sizeof(u8));
+		if (header.version != KMD_VERSION
+			&& header.version != KMD_VERSION_2)
+		{
+			return ImportResult::RESULT_INVALID_VERSION;
 		}
 		
-		ifstream in(inFile, ios::in | ios::binary);
+		memcpy(&header.scaleFactor, data + 5,  sizeof(u8));
+		//clamp to 0 for out of range values
+		if (header.scaleFactor > 8) header.scaleFactor = 0;
 		
-		try
+		memcpy(&header.modelCount, data + 6,  sizeof(u32));
+		
+		//version 2 has no count or size limits, importers check every region
+		//against the file size instead before reading it
+		if (header.version == KMD_VERSION_2)
 		{
-			vector<u8> headerData(CORRECT_MODEL_HEADER_SIZE);
-			
-			in.read(
-				rcast<char*>(headerData.data()),
-				scast<streamsize>(CORRECT_MODEL_HEADER_SIZE));
-				
-			in.close();	
-			
-			ModelHeader header{};
-			
-			//model header
-			
-			memcpy(&header.magic, headerData.data() + 0, sizeof(u32));
-			if (header.magic != KMD_MAGIC) return ImportResult::RESULT_INVALID_MAGIC;
+			memcpy(&header.modelTablesSize, data + 10, sizeof(u64));
+			memcpy(&header.modelBlocksSize, data + 18, sizeof(u64));
 			
-			memcpy(&header.version, headerData.data() + 4, sizeof(u8));
-			if (header.version != KMD_VERSION) return ImportResult::RESULT_INVALID_VERSION;
-			
-			memcpy(&header.scaleFactor, headerData.data() + 5,  sizeof(u8));
-			//clamp to 0 for out of range values
-			if (header.scaleFactor > 8) header.scaleFactor = 0;
-			
-			memcpy(&header.modelCount, headerData.data() + 6,  sizeof(u32));
-			if (header.modelCount > MAX_MODEL_COUNT) return ImportResult::RESULT_INVALID_MODEL_COUNT;
-
-			memcpy(&header.modelTablesSize, headerData.data() + 10, sizeof(u32));
-			if (header.modelTablesSize < CORRECT_MODEL_TABLE_SIZE
-				|| header.modelTablesSize > MAX_MODEL_TABLE_SIZE)
+			if (header.modelCount == 0) return ImportResult::RESULT_INVALID_MODEL_COUNT;
+			if (header.modelTablesSize != scast<u64>(header.modelCount) * CORRECT_MODEL_TABLE_SIZE_V2)
 			{
 				return ImportResult::RESULT_INVALID_MODEL_TABLE_SIZE;
 			}
-			
-			memcpy(&header.modelBlocksSize, headerData.data() + 14, sizeof(u32));
-			if (header.modelBlocksSize < VERTICE_DATA_OFFSET
-				|| header.modelBlocksSize > MAX_MODEL_BLOCK_SIZE)
-			{
-				return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
-			}
+			if (header.modelBlocksSize < VERTICE_DATA_OFFSET) return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
 			
 			outHeader = header;
 			
 			return ImportResult::RESULT_SUCCESS;
 		}
-		catch (...)
+		
+		if (header.modelCount > MAX_MODEL_COUNT) return ImportResult::RESULT_INVALID_MODEL_COUNT;
+		
+		u32 tablesSize{};
+		memcpy(&tablesSize, data + 10, sizeof(u32));
+		if (tablesSize < CORRECT_MODEL_TABLE_SIZE
+			|| tablesSize > MAX_MODEL_TABLE_SIZE)
 		{
-			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			return ImportResult::RESULT_INVALID_MODEL_TABLE_SIZE;
+		}
+		
+		u32 blocksSize{};
+		memcpy(&blocksSize, data + 14, sizeof(u32));
+		if (blocksSize < VERTICE_DATA_OFFSET
+			|| blocksSize > MAX_MODEL_BLOCK_SIZE)
+		{
+			return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
 		}
+		
+		header.modelTablesSize = tablesSize;
+		header.modelBlocksSize = blocksSize;
+		
+		outHeader = header;
+		
+		return ImportResult::RESULT_SUCCESS;
 	}
 	
-	//Loads the kmd tables for streaming models at runtime,
-	//set skipChecks to true if the file has already been checked
-	inline ImportResult GetTableData(
-		const path& inFile,
-		vector<ModelTable>& outTables,
-		bool skipChecks = false)
+	//True if the size bytes at offset are inside the region of regionSize bytes at regionStart,
+	//compared as differences so offsets and sizes near 2^64 can't wrap past the check
+	inline bool IsInsideRegion(
+		u64 offset,
+		u64 size,
+		u64 regionStart,
+		u64 regionSize)
+	{
+		return offset >= regionStart
+			&& offset - regionStart <= regionSize
+			&& size <= regionSize - (offset - regionStart);
+	}
+	
+	//Decodes the model table at index from the raw model tables of the file with this header,
+	//tables whose block is not inside the block region of the header are rejected
+	inline ImportResult ReadModelTable(
+		const u8* tableData,
+		size_t index,
+		const ModelHeader& header,
+		ModelTable& outTable)
 	{
-		if (!skipChecks)
+		const u8* entry = tableData + index * GetTableSize(header.version);
+		
+		ModelTable t{};
+		memcpy(t.nodeName, entry, sizeof(t.nodeName));
+		
+		if (header.version == KMD_VERSION_2)
 		{
-			ImportResult preReadResult = PreReadCheck(inFile);
-			if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+			u64 blockSize{};
+			memcpy(&t.blockOffset, entry + 20, sizeof(u64));
+			memcpy(&blockSize,     entry + 28, sizeof(u64));
 			
-			ImportResult tryOpenResult = TryOpenCheck(inFile);
-			if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+			if (blockSize > MAX_SINGLE_BLOCK_SIZE) return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
+			
+			t.blockSize = scast<u32>(blockSize);
 		}
-		
-		ModelHeader header{};
+		else
+		{
+			u32 blockOffset{};
+			memcpy(&blockOffset, entry + 20, sizeof(u32));
+			memcpy(&t.blockSize, entry + 24, sizeof(u32));
 			
-		ImportResult headerResult = GetHeaderData(
-			inFile,
-			header,
-			true);
-				
-		if (headerResult != ImportResult::RESULT_SUCCESS) return headerResult;
+			t.blockOffset = blockOffset;
+		}
+		
+		if (!IsInsideRegion(
+			t.blockOffset,
+			t.blockSize,
+			GetHeaderSize(header.version) + header.modelTablesSize,
+			header.modelBlocksSize))
+		{
+			return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
+		}
 		
-		ifstream in(inFile, ios::in | ios::binary);
+		outTable = t;
 		
-		try
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//How much of every model block the importers verify while loading it,
+	//bounds are always checked so no mode can read past a block
+	enum class ValidationMode : u8
+	{
+		VALIDATION_DEFAULT  = 0, //field range checks, stored checksums are ignored
+		VALIDATION_TRUSTED  = 1, //stored checksums only, blocks without one still get the field range checks
+		VALIDATION_PARANOID = 2  //stored checksums, field range checks and a scan of every vertex and index
+	};
+	
+	//CRC32C (Castagnoli, reflected polynomial 0x82F63B78) tables for 8 bytes per step
+	inline constexpr array<array<u32, 256>, 8> CRC32C_TABLES = []()
+	{
+		array<array<u32, 256>, 8> tables{};
+		
+		for (u32 i = 0; i < 256; i++)
 		{
-			vector<u8> tablesData(header.modelTablesSize);
-			
-			//start at the end of the top header
-			in.seekg(CORRECT_MODEL_HEADER_SIZE);
+			u32 crc = i;
+			for (u32 bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
 			
-			//read in the size of all tables
-			in.read(
-				rcast<char*>(tablesData.data()),
-				scast<streamsize>(header.modelTablesSize));
-				
-			in.close();	
+			tables[0][i] = crc;
+		}
+		for (u32 i = 0; i < 256; i++)
+		{
+			for (u32 t = 1; t < 8; t++) tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+		}
 		
-			vector<ModelTable> tables{};
-			tables.reserve(header.modelCount);
-			
-			for (size_t i = 0; 
-				i < header.modelTablesSize; 
-				i += CORRECT_MODEL_TABLE_SIZE)
-			{
-				ModelTable t{};
-				
-				memcpy(t.nodeName,     tablesData.data() + i + 0, sizeof(t.nodeName));
-				memcpy(&t.blockOffset, tablesData.data() + i + 20, sizeof(u32));
-				memcpy(&t.blockSize,   tablesData.data() + i + 24, sizeof(u32));
-				
-				tables.push_back(t);
-			}
-			
-			outTables = move(tables);
-			
-			return ImportResult::RESULT_SUCCESS;
+		return tables;
+	}();
+	
+	//Returns the CRC32C of size bytes at data, pass the previous result as crc to continue it.
+	//Uses the SSE 4.2 or ARMv8 crc32c instructions if the target has them, 8-byte table slicing otherwise
+	inline u32 ComputeCRC32C(
+		const u8* data,
+		size_t size,
+		u32 crc = 0)
+	{
+		crc = ~crc;
+		
+#if defined(KALA_KMD_CRC32C_SSE42)
+		u64 crc64 = crc;
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			u64 word{};
+			memcpy(&word, data, sizeof(u64));
+			crc64 = _mm_crc32_u64(crc64, word);
 		}
-		catch (...)
+		crc = scast<u32>(crc64);
+		
+		for (; size > 0; data++, size--) crc = _mm_crc32_u8(crc, *data);
+#elif defined(KALA_KMD_CRC32C_ARM)
+		for (; size >= 8; data += 8, size -= 8)
 		{
-			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			u64 word{};
+			memcpy(&word, data, sizeof(u64));
+			crc = __crc32cd(crc, word);
+		}
+		
+		for (; size > 0; data++, size--) crc = __crc32cb(crc, *data);
+#else
+		const auto& t = CRC32C_TABLES;
+		
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			u32 low{};
+			u32 high{};
+			memcpy(&low, data, sizeof(u32));
+			memcpy(&high, data + 4, sizeof(u32));
+			
+			low ^= crc;
+			crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+				^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
 		}
+		
+		for (; size > 0; data++, size--) crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+#endif
+		
+		return ~crc;
 	}
 	
-	//Returns model blocks for the inserted tables, set skipChecks to true if the file has already been checked
-	inline ImportResult StreamModels(
-		const path& inFile,
-		const vector<ModelTable>& inTables,
-		vector<ModelBlock>& outBlocks,
-		bool skipChecks = false)
+	//Returns true if every vertex value is finite and every index points to one of the vertices.
+	//Both loops are branch-free reductions over 32-bit words so compilers vectorize them
+	inline bool IsValidBlockPayload(
+		const u8* vertexData,
+		size_t vertexCount,
+		const u8* indexData,
+		size_t indexCount)
 	{
-		if (!skipChecks)
+		//all exponent bits set means Inf or NaN
+		constexpr u32 exponentMask = 0x7F800000u;
+		
+		size_t valueCount = vertexCount * (sizeof(Vertex) / sizeof(f32));
+		
+		u32 nonFinite{};
+		for (size_t i = 0; i < valueCount; i++)
 		{
-			ImportResult preReadResult = PreReadCheck(inFile);
-			if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+			u32 bits{};
+			memcpy(&bits, vertexData + i * sizeof(u32), sizeof(u32));
 			
-			ImportResult tryOpenResult = TryOpenCheck(inFile);
-			if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+			nonFinite |= scast<u32>((bits & exponentMask) == exponentMask);
 		}
 		
-		try
+		u32 maxIndex{};
+		for (size_t i = 0; i < indexCount; i++)
 		{
-			ifstream in(inFile, ios::in | ios::binary);
+			u32 index{};
+			memcpy(&index, indexData + i * sizeof(u32), sizeof(u32));
 			
-			in.seekg(0, ios::end);
-			size_t fileSize = scast<size_t>(in.tellg());
+			maxIndex = max(maxIndex, index);
+		}
+		
+		return nonFinite == 0
+			&& (indexCount == 0
+			|| maxIndex < vertexCount);
+	}
+	
+	//Compares the block against its stored checksum unless mode is VALIDATION_DEFAULT, checksum
+	//is nullptr for blocks without one. outIsCheckingFields tells if the field range checks must still run
+	inline ImportResult VerifyBlockChecksum(
+		const u8* blockData,
+		size_t blockSize,
+		ValidationMode mode,
+		const u32* checksum,
+		bool& outIsCheckingFields)
+	{
+		outIsCheckingFields = mode != ValidationMode::VALIDATION_TRUSTED
+			|| checksum == nullptr;
+		
+		if (mode == ValidationMode::VALIDATION_DEFAULT
+			|| checksum == nullptr)
+		{
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		return ComputeCRC32C(blockData, blockSize) == *checksum
+			? ImportResult::RESULT_SUCCESS
+			: ImportResult::RESULT_CHECKSUM_MISMATCH;
+	}
+	
+	//Validates the fixed fields of a model block
+	inline ImportResult ValidateBlockFields(
+		u8 dataTypeFlags,
+		u8 renderType,
+		const f32 (&position)[3],
+		const f32 (&rotation)[4],
+		const f32 (&size)[3])
+	{
+		//data flags go from 0 to 4
+		if (dataTypeFlags & ~0b00011111) return ImportResult::RESULT_INVALID_DATA_FLAGS;
+		
+		//render type goes from 0 to 2
+		if (renderType > 2) return ImportResult::RESULT_INVALID_RENDER_TYPE;
+		
+		for (f32 p : position)
+		{
+			if (p < MIN_POS || p > MAX_POS) return ImportResult::RESULT_INVALID_MODEL_POSITION;
+		}
+		for (f32 r : rotation)
+		{
+			if (r < MIN_ROT || r > MAX_ROT) return ImportResult::RESULT_INVALID_MODEL_ROTATION;
+		}
+		for (f32 s : size)
+		{
+			if (s < MIN_SIZE || s > MAX_SIZE) return ImportResult::RESULT_INVALID_MODEL_SIZE;
+		}
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Copies count values from data to out in one pass, without first value-initializing
+	//out, misaligned data falls back to resize and memcpy
+	template <typename Container>
+	inline void AssignFromBytes(
+		Container& out,
+		const u8* data,
+		size_t count)
+	{
+		using T = typename Container::value_type;
+		
+		if (out.capacity() < count)
+		{
+			AddTelemetry(&LoadTelemetry::allocationCount, 1);
+			AddTelemetry(&LoadTelemetry::allocationBytes, count * sizeof(T));
+		}
+		
+		if (rcast<uintptr_t>(data) % alignof(T) == 0)
+		{
+			const T* first = rcast<const T*>(data);
+			out.assign(first, first + count);
+			
+			return;
+		}
+		
+		out.resize(count);
+		memcpy(out.data(), data, count * sizeof(T));
+	}
+	
+	//Parses and validates the fixed fields of the model block of blockSize bytes at blockData
+	//into any block type with the fixed fields of ModelBlock, vertices and indices are left untouched.
+	//isCheckingFields false skips the field range checks for blocks whose checksum was verified
+	template <typename Block>
+	inline ImportResult ParseBlockFields(
+		const u8* blockData,
+		size_t blockSize,
+		Block& outBlock,
+		bool isCheckingFields = true)
+	{
+		if (blockSize < VERTICE_DATA_OFFSET) return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
+		
+		Block& b = outBlock;
+		
+		memcpy(b.nodeName, blockData + 0, 20);
+		memcpy(b.meshName, blockData + 20, 20);
+		memcpy(b.nodePath, blockData + 40, 50);
+		
+		b.dataTypeFlags = blockData[90];
+		b.renderType = blockData[91];
+		
+		memcpy(b.position, blockData + 92, sizeof(b.position));
+		memcpy(b.rotation, blockData + 104, sizeof(b.rotation));
+		memcpy(b.size, blockData + 120, sizeof(b.size));
+		
+		if (isCheckingFields)
+		{
+			ImportResult fieldResult = ValidateBlockFields(
+				b.dataTypeFlags,
+				b.renderType,
+				b.position,
+				b.rotation,
+				b.size);
+			
+			if (fieldResult != ImportResult::RESULT_SUCCESS) return fieldResult;
+		}
+		
+		memcpy(&b.verticesOffset, blockData + 132, sizeof(u32));
+		memcpy(&b.verticesSize,   blockData + 136, sizeof(u32));
+		memcpy(&b.indicesOffset,  blockData + 140, sizeof(u32));
+		memcpy(&b.indicesSize,    blockData + 144, sizeof(u32));
+		
+		//verify that vertices and indices are not OOB
+		if (scast<size_t>(VERTICE_DATA_OFFSET) + b.verticesSize + b.indicesSize > blockSize)
+		{
+			return ImportResult::RESULT_UNEXPECTED_EOF;
+		}
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Parses and validates the model block at blockData straight into outBlock, so the vertices
+	//and indices are allocated with the allocator outBlock already has. outBlock is left
+	//partially written if the block is invalid. checksum is the stored checksum of the block or nullptr
+	template <typename Block>
+	inline ImportResult ParseBlockInto(
+		const u8* blockData,
+		size_t blockSize,
+		Block& outBlock,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT,
+		const u32* checksum = nullptr)
+	{
+		bool isCheckingFields{};
+		
+		ImportResult checksumResult = VerifyBlockChecksum(
+			blockData,
+			blockSize,
+			mode,
+			checksum,
+			isCheckingFields);
+		
+		if (checksumResult != ImportResult::RESULT_SUCCESS) return checksumResult;
+		
+		ImportResult fieldResult = ParseBlockFields(
+			blockData,
+			blockSize,
+			outBlock,
+			isCheckingFields);
+		
+		if (fieldResult != ImportResult::RESULT_SUCCESS) return fieldResult;
+		
+		if (mode == ValidationMode::VALIDATION_PARANOID
+			&& !IsValidBlockPayload(
+				blockData + VERTICE_DATA_OFFSET,
+				outBlock.verticesSize / sizeof(Vertex),
+				blockData + VERTICE_DATA_OFFSET + outBlock.verticesSize,
+				outBlock.indicesSize / sizeof(u32)))
+		{
+			return ImportResult::RESULT_INVALID_VERTEX_DATA;
+		}
+		
+		AssignFromBytes(
+			outBlock.vertices,
+			blockData + VERTICE_DATA_OFFSET,
+			outBlock.verticesSize / sizeof(Vertex));
+		
+		AssignFromBytes(
+			outBlock.indices,
+			blockData + VERTICE_DATA_OFFSET + outBlock.verticesSize,
+			outBlock.indicesSize / sizeof(u32));
+		
+		AddTelemetry(&LoadTelemetry::blocksDecoded, 1);
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Parses and validates the model block of blockSize bytes at blockData, vertices and indices
+	//are copied so blockData can be released afterwards. checksum is the stored checksum of the block or nullptr
+	inline ImportResult ParseBlock(
+		const u8* blockData,
+		size_t blockSize,
+		ModelBlock& outBlock,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT,
+		const u32* checksum = nullptr)
+	{
+		ModelBlock b{};
+		
+		ImportResult blockResult = ParseBlockInto(
+			blockData,
+			blockSize,
+			b,
+			mode,
+			checksum);
+		
+		if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+		
+		outBlock = move(b);
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Returns an empty PmrModelBlock whose vertices and indices allocate from resource
+	inline PmrModelBlock MakePmrBlock(memory_resource* resource)
+	{
+		return PmrModelBlock{
+			.vertices = std::pmr::vector<Vertex>(resource),
+			.indices = std::pmr::vector<u32>(resource) };
+	}
+	
+	//
+	// NAME INDEX
+	//
+	
+	//Returns the fixed-length name as a view without its null padding
+	inline string_view FixedNameView(
+		const u8* data,
+		size_t maxLength)
+	{
+		const char* name = rcast<const char*>(data);
+		
+		size_t length{};
+		while (length < maxLength
+			&& name[length] != '\0')
+		{
+			length++;
+		}
+		
+		return string_view(name, length);
+	}
+	
+	//Returns the 32-bit FNV-1a hash of a model node name
+	inline u32 HashModelName(string_view name)
+	{
+		u32 hash = 2166136261u;
+		for (char c : name)
+		{
+			hash ^= scast<u8>(c);
+			hash *= 16777619u;
+		}
+		
+		return hash;
+	}
+	
+	//Returns the payload of the first trailing section with this tag,
+	//trailingData points to the first byte after the model blocks
+	inline bool FindSection(
+		const u8* trailingData,
+		size_t trailingSize,
+		u32 tag,
+		span<const u8>& outPayload)
+	{
+		size_t offset{};
+		while (offset + SECTION_HEADER_SIZE <= trailingSize)
+		{
+			u32 sectionTag{};
+			u32 sectionSize{};
+			memcpy(&sectionTag,  trailingData + offset, sizeof(u32));
+			memcpy(&sectionSize, trailingData + offset + 4, sizeof(u32));
+			
+			offset += SECTION_HEADER_SIZE;
+			if (sectionSize > trailingSize - offset) return false;
+			
+			if (sectionTag == tag)
+			{
+				outPayload = span<const u8>(trailingData + offset, sectionSize);
+				return true;
+			}
+			
+			offset += sectionSize;
+		}
+		
+		return false;
+	}
+	
+	//Returns true if the name index has one entry per model in sorted order,
+	//malformed indexes are ignored by importers and lookups fall back to a table scan
+	inline bool IsValidNameIndex(
+		span<const u8> nameIndex,
+		u32 modelCount)
+	{
+		if (nameIndex.size() != scast<size_t>(modelCount) * NAME_INDEX_ENTRY_SIZE) return false;
+		
+		u32 lastHash{};
+		for (size_t i = 0; i < modelCount; i++)
+		{
+			u32 hash{};
+			u32 index{};
+			memcpy(&hash,  nameIndex.data() + i * NAME_INDEX_ENTRY_SIZE, sizeof(u32));
+			memcpy(&index, nameIndex.data() + i * NAME_INDEX_ENTRY_SIZE + 4, sizeof(u32));
+			
+			if (index >= modelCount
+				|| hash < lastHash)
+			{
+				return false;
+			}
+			
+			lastHash = hash;
+		}
+		
+		return true;
+	}
+	
+	//Builds the name index section with its section header for modelCount raw model tables of a file of this version
+	inline void BuildNameIndex(
+		const u8* tableData,
+		u32 modelCount,
+		vector<u8>& outSection,
+		u8 version = KMD_VERSION)
+	{
+		size_t tableSize = GetTableSize(version);
+		
+		vector<array<u32, 2>> entries(modelCount);
+		for (u32 i = 0; i < modelCount; i++)
+		{
+			entries[i] = { HashModelName(FixedNameView(tableData + i * tableSize, 20)), i };
+		}
+		
+		//sorting by index too keeps the first model of duplicate names first
+		std::sort(entries.begin(), entries.end());
+		
+		u32 payloadSize = modelCount * NAME_INDEX_ENTRY_SIZE;
+		
+		outSection.resize(SECTION_HEADER_SIZE + payloadSize);
+		memcpy(outSection.data(), &NAME_INDEX_TAG, sizeof(u32));
+		memcpy(outSection.data() + 4, &payloadSize, sizeof(u32));
+		if (payloadSize > 0) memcpy(outSection.data() + SECTION_HEADER_SIZE, entries.data(), payloadSize);
+	}
+	
+	//Finds the first model whose node name matches name straight from the raw model tables of a file of this
+	//version, uses a binary search over nameIndex if it is not empty and a table scan otherwise
+	inline bool FindModelIndex(
+		const u8* tableData,
+		u32 modelCount,
+		span<const u8> nameIndex,
+		string_view name,
+		u32& outIndex,
+		u8 version = KMD_VERSION)
+	{
+		size_t tableSize = GetTableSize(version);
+		
+		auto nameAt = [&](u32 index)
+			{
+				return FixedNameView(tableData + scast<size_t>(index) * tableSize, 20);
+			};
+		
+		if (nameIndex.empty())
+		{
+			for (u32 i = 0; i < modelCount; i++)
+			{
+				if (nameAt(i) == name)
+				{
+					outIndex = i;
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		auto entryAt = [&](size_t entry, size_t field)
+			{
+				u32 value{};
+				memcpy(&value, nameIndex.data() + entry * NAME_INDEX_ENTRY_SIZE + field * 4, sizeof(u32));
+				return value;
+			};
+		
+		u32 hash = HashModelName(name);
+		
+		//lower bound of the hash, then compare names until the hash changes
+		size_t low{};
+		size_t high = modelCount;
+		while (low < high)
+		{
+			size_t mid = low + (high - low) / 2;
+			if (entryAt(mid, 0) < hash) low = mid + 1;
+			else high = mid;
+		}
+		
+		for (size_t i = low; 
+			i < modelCount
+			&& entryAt(i, 0) == hash; 
+			i++)
+		{
+			u32 index = entryAt(i, 1);
+			if (nameAt(index) == name)
+			{
+				outIndex = index;
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	//
+	// CHECKSUM SECTION
+	//
+	
+	//Stored checksum of the model block at blockOffset
+	struct BlockChecksum
+	{
+		u64 blockOffset{};
+		u32 checksum{};
+	};
+	
+	//Builds the checksum section with its section header from one checksum per model in table order
+	inline void BuildChecksumSection(
+		span<const u32> checksums,
+		vector<u8>& outSection)
+	{
+		u32 payloadSize = scast<u32>(checksums.size_bytes());
+		
+		outSection.resize(SECTION_HEADER_SIZE + payloadSize);
+		memcpy(outSection.data(), &CHECKSUM_TAG, sizeof(u32));
+		memcpy(outSection.data() + 4, &payloadSize, sizeof(u32));
+		if (payloadSize > 0) memcpy(outSection.data() + SECTION_HEADER_SIZE, checksums.data(), payloadSize);
+	}
+	
+	//Pairs the checksums of a checksum section with the block offsets of modelCount raw model tables of the file
+	//with this header, sorted by offset for FindBlockChecksum. Sections without one checksum per model are ignored
+	inline void ReadBlockChecksums(
+		span<const u8> payload,
+		const u8* tableData,
+		u32 modelCount,
+		vector<BlockChecksum>& outChecksums,
+		const ModelHeader& header)
+	{
+		outChecksums.clear();
+		
+		if (payload.size() != scast<size_t>(modelCount) * sizeof(u32)) return;
+		
+		outChecksums.resize(modelCount);
+		for (u32 i = 0; i < modelCount; i++)
+		{
+			ModelTable t{};
+			ReadModelTable(tableData, i, header, t);
+			
+			outChecksums[i].blockOffset = t.blockOffset;
+			memcpy(&outChecksums[i].checksum, payload.data() + i * sizeof(u32), sizeof(u32));
+		}
+		
+		std::sort(
+			outChecksums.begin(),
+			outChecksums.end(),
+			[](const BlockChecksum& a, const BlockChecksum& b) { return a.blockOffset < b.blockOffset; });
+	}
+	
+	//Returns the stored checksum of the block at blockOffset or nullptr if it has none
+	inline const u32* FindBlockChecksum(
+		span<const BlockChecksum> checksums,
+		u64 blockOffset)
+	{
+		auto it = std::lower_bound(
+			checksums.begin(),
+			checksums.end(),
+			blockOffset,
+			[](const BlockChecksum& c, u64 offset) { return c.blockOffset < offset; });
+		
+		return it != checksums.end() && it->blockOffset == blockOffset
+			? &it->checksum
+			: nullptr;
+	}
+	
+	//
+	// NATIVE FILE
+	//
+	
+#ifdef _WIN32
+	using NativeFile = HANDLE;
+	inline const NativeFile INVALID_NATIVE_FILE = INVALID_HANDLE_VALUE;
+#else
+	using NativeFile = int;
+	constexpr NativeFile INVALID_NATIVE_FILE = -1;
+#endif
+	
+	//Opens the file for reading with the OS api, returns INVALID_NATIVE_FILE on failure and
+	//outResult says why. Windows handles are overlapped so reads from many threads don't queue on the handle
+	inline NativeFile OpenNativeFile(
+		const path& inFile,
+		ImportResult& outResult)
+	{
+		outResult = ImportResult::RESULT_SUCCESS;
+		
+#ifdef _WIN32
+		NativeFile file = CreateFileW(
+			inFile.wstring().c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+			nullptr);
+		
+		if (file != INVALID_NATIVE_FILE) return file;
+		
+		switch (GetLastError())
+		{
+		case ERROR_FILE_NOT_FOUND:
+		case ERROR_PATH_NOT_FOUND:
+			outResult = ImportResult::RESULT_FILE_NOT_FOUND;
+			break;
+		case ERROR_ACCESS_DENIED:
+			outResult = ImportResult::RESULT_UNAUTHORIZED_READ;
+			break;
+		case ERROR_SHARING_VIOLATION:
+		case ERROR_LOCK_VIOLATION:
+			outResult = ImportResult::RESULT_FILE_LOCKED;
+			break;
+		default:
+			outResult = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			break;
+		}
+#else
+		NativeFile file = open(inFile.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file != INVALID_NATIVE_FILE) return file;
+		
+		switch (errno)
+		{
+		case ENOENT:
+			outResult = ImportResult::RESULT_FILE_NOT_FOUND;
+			break;
+		case EACCES:
+		case EPERM:
+			outResult = ImportResult::RESULT_UNAUTHORIZED_READ;
+			break;
+		case EBUSY:
+		case ETXTBSY:
+			outResult = ImportResult::RESULT_FILE_LOCKED;
+			break;
+		default:
+			outResult = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			break;
+		}
+#endif
+		
+		return INVALID_NATIVE_FILE;
+	}
+	
+	inline void CloseNativeFile(NativeFile& file)
+	{
+		if (file == INVALID_NATIVE_FILE) return;
+		
+#ifdef _WIN32
+		CloseHandle(file);
+#else
+		close(file);
+#endif
+		file = INVALID_NATIVE_FILE;
+	}
+	
+	//Gets the size of a regular file, returns false for directories, pipes and devices
+	inline bool GetNativeFileSize(
+		NativeFile file,
+		u64& outSize)
+	{
+#ifdef _WIN32
+		LARGE_INTEGER size{};
+		if (GetFileType(file) != FILE_TYPE_DISK
+			|| !GetFileSizeEx(file, &size))
+		{
+			return false;
+		}
+		
+		outSize = scast<u64>(size.QuadPart);
+#else
+		struct stat fileStat{};
+		if (fstat(file, &fileStat) != 0
+			|| !S_ISREG(fileStat.st_mode))
+		{
+			return false;
+		}
+		
+		outSize = scast<u64>(fileStat.st_size);
+#endif
+		return true;
+	}
+	
+	//Reads size bytes at offset without moving any shared file position,
+	//so any number of threads can read through the same handle at once
+	inline ImportResult ReadFileAt(
+		NativeFile file,
+		u64 offset,
+		u32 size,
+		u8* out)
+	{
+		AddTelemetry(&LoadTelemetry::bytesRead, size);
+		
+#ifdef _WIN32
+		//each thread waits for its own reads on its own event
+		struct ReadEvent
+		{
+			HANDLE handle = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+			~ReadEvent() { if (handle) CloseHandle(handle); }
+		};
+		thread_local ReadEvent event{};
+		
+		if (!event.handle) return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+#endif
+		
+		u32 done{};
+		while (done < size)
+		{
+			AddTelemetry(&LoadTelemetry::syscallCount, 1);
+			
+#ifdef _WIN32
+			OVERLAPPED overlapped{};
+			overlapped.Offset = scast<DWORD>(offset + done);
+			overlapped.OffsetHigh = scast<DWORD>((offset + done) >> 32);
+			overlapped.hEvent = event.handle;
+			
+			DWORD readCount{};
+			bool isRead = ReadFile(
+				file,
+				out + done,
+				size - done,
+				nullptr,
+				&overlapped)
+				|| GetLastError() == ERROR_IO_PENDING;
+			
+			if (isRead) isRead = GetOverlappedResult(file, &overlapped, &readCount, TRUE);
+			
+			if (!isRead)
+			{
+				return GetLastError() == ERROR_HANDLE_EOF
+					? ImportResult::RESULT_UNEXPECTED_EOF
+					: ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+#else
+			ssize_t readCount = pread(
+				file,
+				out + done,
+				size - done,
+				scast<off_t>(offset + done));
+			
+			if (readCount < 0)
+			{
+				if (errno == EINTR) continue;
+				return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+#endif
+			if (readCount == 0) return ImportResult::RESULT_UNEXPECTED_EOF;
+			
+			done += scast<u32>(readCount);
+		}
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//
+	// FILE HANDLE IMPORT
+	//
+	
+	//Counters of the block reads of a KmdFile since it was opened
+	struct ReadStats
+	{
+		u64 readCount{}; //reads issued to the file
+		u64 bytesRead{}; //bytes read including the gaps between merged blocks
+		u64 bytesUsed{}; //bytes of the requested blocks
+		f64 seconds{};   //wall time spent in ReadBlocks
+	};
+	
+	//Kmd file that stays open for its whole lifetime, Open validates the file and reads
+	//the header and all tables with a single read, every block read reuses the same handle
+	class KmdFile
+	{
+	public:
+		KmdFile() = default;
+		~KmdFile() { Close(); }
+		
+		KmdFile(const KmdFile&) = delete;
+		KmdFile& operator=(const KmdFile&) = delete;
+		
+		//Validates the file and loads its tables, mode picks how blocks are verified when they are read
+		ImportResult Open(
+			const path& inFile,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			Close();
+			
+			validationMode = mode;
+			
+			if (!inFile.has_extension()
+				|| inFile.extension() != ".kmd")
+			{
+				return ImportResult::RESULT_INVALID_EXTENSION;
+			}
+			
+			try
+			{
+				AddTelemetry(&LoadTelemetry::openCount, 1);
+				
+				{
+					PhaseTimer openTimer(LoadPhase::PHASE_OPEN);
+					
+					ImportResult openResult{};
+					
+					file = OpenNativeFile(inFile, openResult);
+					if (file == INVALID_NATIVE_FILE) return openResult;
+					
+					//non-regular files such as directories may open but have no size
+					u64 endPos{};
+					if (!GetNativeFileSize(file, endPos))
+					{
+						Close();
+						return ImportResult::RESULT_INVALID_EXTENSION;
+					}
+					
+					fileSize = scast<size_t>(endPos);
+					
+					if (fileSize == 0)
+					{
+						Close();
+						return ImportResult::RESULT_FILE_EMPTY;
+					}
+					if (fileSize < MIN_TOTAL_SIZE)
+					{
+						Close();
+						return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
+					}
+				}
+				
+				//the header and the largest version 1 table region fit in one small read,
+				//only larger version 2 tables need a second one
+				vector<u8> prefix(min(fileSize, scast<size_t>(CORRECT_MODEL_HEADER_SIZE_V2 + MAX_MODEL_TABLE_SIZE)));
+				
+				ImportResult readResult{};
+				
+				{
+					PhaseTimer headerTimer(LoadPhase::PHASE_HEADER);
+					
+					readResult = ReadBytes(
+						0,
+						prefix.size(),
+						prefix.data());
+					
+					if (readResult == ImportResult::RESULT_SUCCESS) readResult = ParseHeader(prefix.data(), header);
+				}
+				{
+					PhaseTimer tablesTimer(LoadPhase::PHASE_TABLES);
+					
+					if (readResult == ImportResult::RESULT_SUCCESS) readResult = ReadRemainingTables(prefix);
+					if (readResult == ImportResult::RESULT_SUCCESS) readResult = ParseTables(prefix);
+					if (readResult == ImportResult::RESULT_SUCCESS) readResult = ReadTrailingSections();
+				}
+				
+				if (readResult != ImportResult::RESULT_SUCCESS)
+				{
+					Close();
+					return readResult;
+				}
+				
+				return ImportResult::RESULT_SUCCESS;
+			}
+			catch (...)
+			{
+				Close();
+				return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+		}
+		
+		void Close()
+		{
+			CloseNativeFile(file);
+			
+			header = {};
+			tables.clear();
+			tableBytes.clear();
+			nameIndex.clear();
+			checksums.clear();
+			fileSize = 0;
+			readStats = {};
+		}
+		
+		bool IsOpen() const { return file != INVALID_NATIVE_FILE; }
+		
+		const ModelHeader& GetHeader() const { return header; }
+		const vector<ModelTable>& GetTables() const { return tables; }
+		size_t GetFileSize() const { return fileSize; }
+		
+		//Hands the open handle over to the caller, the file stays open and this KmdFile no longer closes it
+		NativeFile ReleaseNativeFile()
+		{
+			NativeFile released = file;
+			file = INVALID_NATIVE_FILE;
+			
+			return released;
+		}
+		
+		const ReadStats& GetReadStats() const { return readStats; }
+		
+		//Blocks up to newMaxReadGap bytes apart are merged into one read, 0 only merges touching blocks
+		void SetMaxReadGap(u32 newMaxReadGap) { maxReadGap = newMaxReadGap; }
+		
+		//Raw model tables and name index payload, empty if the file has no valid name index
+		const vector<u8>& GetTableBytes() const { return tableBytes; }
+		const vector<u8>& GetNameIndex() const { return nameIndex; }
+		
+		//Stored block checksums sorted by block offset, empty if the file has no valid checksum section
+		const vector<BlockChecksum>& GetChecksums() const { return checksums; }
+		ValidationMode GetValidationMode() const { return validationMode; }
+		
+		//Returns the table of the first model with this node name or nullptr if there is none,
+		//files with a name index are searched in O(log n) without touching the tables
+		const ModelTable* FindModel(string_view name) const
+		{
+			u32 index{};
+			if (!FindModelIndex(
+				tableBytes.data(),
+				scast<u32>(tables.size()),
+				nameIndex,
+				name,
+				index,
+				header.version))
+			{
+				return nullptr;
+			}
+			
+			return &tables[index];
+		}
+		
+		//Reads size bytes starting from the absolute offset to out
+		ImportResult ReadBytes(
+			size_t offset,
+			size_t size,
+			u8* out)
+		{
+			if (!IsInsideRegion(offset, size, 0, fileSize)) return ImportResult::RESULT_UNEXPECTED_EOF;
+			
+			//a single positional read is limited to u32 bytes
+			size_t done{};
+			while (done < size)
+			{
+				u32 chunk = scast<u32>(min(size - done, scast<size_t>(UINT32_MAX)));
+				
+				ImportResult readResult = ReadFileAt(
+					file,
+					offset + done,
+					chunk,
+					out + done);
+				
+				if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+				
+				done += chunk;
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Returns model blocks for the inserted tables in the order of the tables. Blocks are
+		//read in file order and nearby blocks are merged into one read, see SetMaxReadGap
+		ImportResult ReadBlocks(
+			const vector<ModelTable>& inTables,
+			vector<ModelBlock>& outBlocks)
+		{
+			return ReadBlocksWith(
+				inTables,
+				outBlocks,
+				[] { return ModelBlock{}; });
+		}
+		
+		//Returns model blocks for the inserted tables with vertices and indices allocated from resource
+		ImportResult ReadBlocks(
+			const vector<ModelTable>& inTables,
+			vector<PmrModelBlock>& outBlocks,
+			memory_resource* resource)
+		{
+			return ReadBlocksWith(
+				inTables,
+				outBlocks,
+				[resource] { return MakePmrBlock(resource); });
+		}
+	
+	private:
+		NativeFile file = INVALID_NATIVE_FILE;
+		size_t fileSize{};
+		
+		ModelHeader header{};
+		vector<ModelTable> tables{};
+		
+		//raw model tables and name index payload for FindModel
+		vector<u8> tableBytes{};
+		vector<u8> nameIndex{};
+		
+		vector<BlockChecksum> checksums{};
+		ValidationMode validationMode{};
+		
+		//reused by ReadBlocks for every block read through this file
+		vector<u8> scratch{};
+		
+		u32 maxReadGap = DEFAULT_MAX_READ_GAP;
+		ReadStats readStats{};
+		
+		//Checks the file size against the limits of its version and reads the tables that
+		//did not fit in the first read, only version 2 tables can be larger than it
+		ImportResult ReadRemainingTables(vector<u8>& prefix)
+		{
+			if (header.version == KMD_VERSION
+				&& fileSize > MAX_TOTAL_SIZE)
+			{
+				return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
+			}
+			
+			size_t tablesEnd = GetHeaderSize(header.version) + header.modelTablesSize;
+			
+			if (tablesEnd > fileSize) return ImportResult::RESULT_UNEXPECTED_EOF;
+			
+			//version 2 block sizes are not capped by the header, so the block region
+			//is checked against the file before anything is sized from it
+			if (header.version == KMD_VERSION_2
+				&& header.modelBlocksSize > fileSize - tablesEnd)
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+			if (tablesEnd <= prefix.size()) return ImportResult::RESULT_SUCCESS;
+			
+			size_t readStart = prefix.size();
+			prefix.resize(tablesEnd);
 			
-			//glyph block data
+			return ReadBytes(
+				readStart,
+				tablesEnd - readStart,
+				prefix.data() + readStart);
+		}
+		
+		ImportResult ParseTables(const vector<u8>& prefix)
+		{
+			size_t headerSize = GetHeaderSize(header.version);
 			
-			vector<ModelBlock> blocks{};
-			blocks.reserve(inTables.size());
+			if (headerSize + scast<size_t>(header.modelTablesSize) > prefix.size())
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+			
+			const u8* tablesData = prefix.data() + headerSize;
+			size_t tableCount = header.modelTablesSize / GetTableSize(header.version);
 			
-			for (const auto& t : inTables)
+			tables.reserve(header.modelCount);
+			tableBytes.assign(tablesData, tablesData + header.modelTablesSize);
+			
+			for (size_t i = 0; i < tableCount; i++)
+			{
+				ModelTable t{};
+				
+				ImportResult tableResult = ReadModelTable(
+					tablesData,
+					i,
+					header,
+					t);
+				
+				if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
+				
+				tables.push_back(t);
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Reads the trailing sections after the model blocks and keeps the name index and checksums
+		//if they are valid, files without trailing sections or with malformed ones still open normally
+		ImportResult ReadTrailingSections()
+		{
+			size_t blockRegionEnd = GetHeaderSize(header.version) 
+				+ scast<size_t>(header.modelTablesSize) 
+				+ header.modelBlocksSize;
+			
+			if (blockRegionEnd + SECTION_HEADER_SIZE > fileSize) return ImportResult::RESULT_SUCCESS;
+			
+			vector<u8> trailing(min(fileSize - blockRegionEnd, GetMaxTrailingSize(header.modelCount)));
+			
+			ImportResult readResult = ReadBytes(
+				blockRegionEnd,
+				trailing.size(),
+				trailing.data());
+			
+			if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+			
+			span<const u8> payload{};
+			if (FindSection(
+					trailing.data(),
+					trailing.size(),
+					NAME_INDEX_TAG,
+					payload)
+				&& IsValidNameIndex(payload, scast<u32>(tables.size())))
+			{
+				nameIndex.assign(payload.begin(), payload.end());
+			}
+			
+			if (FindSection(
+				trailing.data(),
+				trailing.size(),
+				CHECKSUM_TAG,
+				payload))
+			{
+				ReadBlockChecksums(
+					payload,
+					tableBytes.data(),
+					scast<u32>(tables.size()),
+					checksums,
+					header);
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Reads the blocks in file order with nearby blocks merged into one read and parses
+		//them into Block values created by makeBlock in the order of inTables. If blocks fail
+		//to parse, the error of the first one in the order of inTables is returned
+		template <typename Block, typename MakeBlock>
+		ImportResult ReadBlocksWith(
+			const vector<ModelTable>& inTables,
+			vector<Block>& outBlocks,
+			MakeBlock&& makeBlock)
+		{
+			auto start = steady_clock::now();
+			
+			size_t count = inTables.size();
+			
+			try
+			{
+				for (const auto& t : inTables)
+				{
+					//verify that block size is not OOB
+					if (!IsInsideRegion(t.blockOffset, t.blockSize, 0, fileSize))
+					{
+						return ImportResult::RESULT_UNEXPECTED_EOF;
+					}
+				}
+				
+				vector<Block> blocks{};
+				blocks.reserve(count);
+				for (size_t i = 0; i < count; i++) blocks.push_back(makeBlock());
+				
+				vector<u32> order(count);
+				iota(order.begin(), order.end(), 0u);
+				stable_sort(
+					order.begin(),
+					order.end(),
+					[&inTables](u32 a, u32 b) { return inTables[a].blockOffset < inTables[b].blockOffset; });
+				
+				size_t firstFailure = count;
+				ImportResult failureResult = ImportResult::RESULT_SUCCESS;
+				
+				for (size_t first = 0; first < count;)
+				{
+					//extend the read while the next block starts within the gap of the read end,
+					//duplicate and overlapping tables are served from the same read
+					size_t readStart = inTables[order[first]].blockOffset;
+					size_t readEnd = readStart + inTables[order[first]].blockSize;
+					
+					size_t last = first + 1;
+					for (; last < count; last++)
+					{
+						const ModelTable& t = inTables[order[last]];
+						size_t blockEnd = scast<size_t>(t.blockOffset) + t.blockSize;
+						
+						if (t.blockOffset > readEnd + maxReadGap
+							|| max(readEnd, blockEnd) - readStart > MAX_COALESCED_READ_SIZE)
+						{
+							break;
+						}
+						
+						readEnd = max(readEnd, blockEnd);
+					}
+					
+					//the buffer only grows to the largest read, blocks keep the
+					//4 byte alignment of their file offsets relative to its start
+					if (scratch.size() < readEnd - readStart)
+					{
+						AddTelemetry(&LoadTelemetry::allocationCount, 1);
+						AddTelemetry(&LoadTelemetry::allocationBytes, readEnd - readStart);
+						
+						scratch.resize(readEnd - readStart);
+					}
+					
+					ImportResult readResult{};
+					{
+						PhaseTimer ioTimer(LoadPhase::PHASE_BLOCK_IO);
+						
+						readResult = ReadBytes(
+							readStart,
+							readEnd - readStart,
+							scratch.data());
+					}
+					
+					if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+					
+					readStats.readCount++;
+					readStats.bytesRead += readEnd - readStart;
+					
+					PhaseTimer parseTimer(LoadPhase::PHASE_BLOCK_PARSE);
+					
+					for (size_t i = first; i < last; i++)
+					{
+						u32 index = order[i];
+						const ModelTable& t = inTables[index];
+						
+						readStats.bytesUsed += t.blockSize;
+						
+						ImportResult blockResult = ParseBlockInto(
+							scratch.data() + (t.blockOffset - readStart),
+							t.blockSize,
+							blocks[index],
+							validationMode,
+							FindBlockChecksum(checksums, t.blockOffset));
+						
+						if (blockResult != ImportResult::RESULT_SUCCESS
+							&& index < firstFailure)
+						{
+							firstFailure = index;
+							failureResult = blockResult;
+						}
+					}
+					
+					first = last;
+				}
+				
+				readStats.seconds += duration<f64>(steady_clock::now() - start).count();
+				
+				if (failureResult != ImportResult::RESULT_SUCCESS) return failureResult;
+				
+				outBlocks = move(blocks);
+				
+				return ImportResult::RESULT_SUCCESS;
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+		}
+	};
+	
+	//Returns header data of the file,
+	//skipChecks is kept for compatibility, KmdFile always validates while opening
+	inline ImportResult GetHeaderData(
+		const path& inFile,
+		ModelHeader& outHeader,
+		[[maybe_unused]] bool skipChecks = false)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		outHeader = file.GetHeader();
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Loads the kmd tables for streaming models at runtime,
+	//skipChecks is kept for compatibility, KmdFile always validates while opening
+	inline ImportResult GetTableData(
+		const path& inFile,
+		vector<ModelTable>& outTables,
+		[[maybe_unused]] bool skipChecks = false)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		outTables = file.GetTables();
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Returns model blocks for the inserted tables, keep a KmdFile open instead
+	//when streaming from the same file repeatedly to skip reopening it every time
+	inline ImportResult StreamModels(
+		const path& inFile,
+		const vector<ModelTable>& inTables,
+		vector<ModelBlock>& outBlocks,
+		[[maybe_unused]] bool skipChecks = false)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		return file.ReadBlocks(inTables, outBlocks);
+	}
+	
+	//Same as StreamModels, but verifies every block as mode asks for
+	inline ImportResult StreamModels(
+		const path& inFile,
+		const vector<ModelTable>& inTables,
+		vector<ModelBlock>& outBlocks,
+		ValidationMode mode)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile, mode);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		return file.ReadBlocks(inTables, outBlocks);
+	}
+	
+	//Same as StreamModels, but reports how many reads were issued for the blocks
+	//and merges blocks up to maxReadGap bytes apart into one read
+	inline ImportResult StreamModels(
+		const path& inFile,
+		const vector<ModelTable>& inTables,
+		vector<ModelBlock>& outBlocks,
+		ReadStats& outStats,
+		u32 maxReadGap = DEFAULT_MAX_READ_GAP)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		file.SetMaxReadGap(maxReadGap);
+		
+		ImportResult readResult = file.ReadBlocks(inTables, outBlocks);
+		outStats = file.GetReadStats();
+		
+		return readResult;
+	}
+	
+	//Returns model blocks for the inserted tables with vertices and indices allocated from resource
+	inline ImportResult StreamModels(
+		const path& inFile,
+		const vector<ModelTable>& inTables,
+		vector<PmrModelBlock>& outBlocks,
+		memory_resource* resource)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		return file.ReadBlocks(
+			inTables,
+			outBlocks,
+			resource);
+	}
+	
+	//ThreadPool shared by the kmd loaders and tools that work on blocks in parallel, started with
+	//one worker per hardware thread the first time a load actually runs on more than one thread
+	inline ThreadPool& GetLoaderPool()
+	{
+		static ThreadPool pool{};
+		return pool;
+	}
+	
+	//Parses the blocks of tables from the block region at blockData into outBlocks on up to
+	//threadCount threads of the loader pool, counting the calling thread. Threads claim blocks
+	//in file order, which is not always table order, and stop claiming past the first failed
+	//block, so the result is always the one of the first failing block in file order
+	template <typename Block>
+	inline ImportResult ParseBlocksParallel(
+		const u8* blockData,
+		size_t blockDataSize,
+		size_t blockRegionStart,
+		const vector<ModelTable>& tables,
+		vector<Block>& outBlocks,
+		u32 threadCount,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT,
+		span<const BlockChecksum> checksums = {})
+	{
+		size_t modelCount = tables.size();
+		
+		vector<ImportResult> results(modelCount, ImportResult::RESULT_SUCCESS);
+		
+		//blocks are claimed by their position in file order, tables are not required to be sorted by offset
+		vector<u32> order(modelCount);
+		iota(order.begin(), order.end(), 0u);
+		stable_sort(
+			order.begin(),
+			order.end(),
+			[&tables](u32 a, u32 b) { return tables[a].blockOffset < tables[b].blockOffset; });
+		
+		atomic<size_t> nextPosition{};
+		atomic<size_t> firstFailure{ modelCount };
+		
+		auto parseBlocks = [&]()
+		{
+			for (size_t p = nextPosition.fetch_add(1); 
+				p < modelCount
+				&& p < firstFailure.load(); 
+				p = nextPosition.fetch_add(1))
 			{
-				ModelBlock b{};
-				
-				size_t offset = t.blockOffset;
+				u32 i = order[p];
+				const ModelTable& t = tables[i];
+
+				ImportResult blockResult = ImportResult::RESULT_UNEXPECTED_EOF;
 				
 				//verify that block size is not OOB
-				if (offset + t.blockSize > fileSize)
+				if (IsInsideRegion(
+					t.blockOffset,
+					t.blockSize,
+					blockRegionStart,
+					blockDataSize))
 				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
+					try
+					{
+						blockResult = ParseBlockInto(
+							blockData + (t.blockOffset - blockRegionStart),
+							t.blockSize,
+							outBlocks[i],
+							mode,
+							FindBlockChecksum(checksums, t.blockOffset));
+					}
+					catch (...)
+					{
+						blockResult = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+					}
 				}
 				
-				in.seekg(offset);
+				if (blockResult == ImportResult::RESULT_SUCCESS) continue;
 				
-				in.read(rcast<char*>(b.nodeName),       20);
-				in.read(rcast<char*>(b.meshName),       20);
-				in.read(rcast<char*>(b.nodePath),       50);
+				results[i] = blockResult;
 				
-				//data flags go from 0 to 4
-				in.read(rcast<char*>(&b.dataTypeFlags), sizeof(u8));
-				if (b.dataTypeFlags & ~0b00011111) return ImportResult::RESULT_INVALID_DATA_FLAGS;
-				
-				//render type goes from 0 to 2
-				in.read(rcast<char*>(&b.renderType),    sizeof(u8));
-				if (b.renderType > 2) return ImportResult::RESULT_INVALID_RENDER_TYPE;
+				size_t failure = firstFailure.load();
+				while (p < failure
+					&& !firstFailure.compare_exchange_weak(failure, p)) {}
+			}
+		};
+		
+		//a single task runs inline, so small or single threaded loads never start the pool
+		u32 taskCount = scast<u32>(min(
+			scast<size_t>(max(threadCount, 1u)),
+			max(modelCount, size_t(1))));
+		
+		//pool tasks record into their own telemetry, it is added to the caller's after the wait
+		LoadTelemetry* sink = GetTelemetrySink();
+		vector<LoadTelemetry> taskTelemetry{};
+		
+		if (taskCount <= 1) parseBlocks();
+		else
+		{
+			try
+			{
+				ThreadPool& pool = GetLoaderPool();
 				
-				f32 newPos[3]{};
-				in.read(rcast<char*>(&newPos[0]), sizeof(f32));
-				in.read(rcast<char*>(&newPos[1]), sizeof(f32));
-				in.read(rcast<char*>(&newPos[2]), sizeof(f32));
+				taskCount = min(taskCount, scast<u32>(pool.size()));
+				taskTelemetry.resize(sink ? taskCount : 0);
 				
-				if (newPos[0] < MIN_POS
-					|| newPos[0] > MAX_POS
-					|| newPos[1] < MIN_POS
-					|| newPos[1] > MAX_POS
-					|| newPos[2] < MIN_POS
-					|| newPos[2] > MAX_POS)
-				{
-					return ImportResult::RESULT_INVALID_MODEL_POSITION;
-				}
+				TaskGroup group(pool);
 				
-				memcpy(b.position, newPos, sizeof(b.position));
-				
-				f32 newRot[4]{};
-				in.read(rcast<char*>(&newRot[0]), sizeof(f32));
-				in.read(rcast<char*>(&newRot[1]), sizeof(f32));
-				in.read(rcast<char*>(&newRot[2]), sizeof(f32));
-				in.read(rcast<char*>(&newRot[3]), sizeof(f32));
-				
-				if (newRot[0] < MIN_ROT
-					|| newRot[0] > MAX_ROT
-					|| newRot[1] < MIN_ROT
-					|| newRot[1] > MAX_ROT
-					|| newRot[2] < MIN_ROT
-					|| newRot[2] > MAX_ROT
-					|| newRot[3] < MIN_ROT
-					|| newRot[3] > MAX_ROT)
+				for (u32 i = 1; i < taskCount; i++)
 				{
-					return ImportResult::RESULT_INVALID_MODEL_ROTATION;
+					group.run([&, i]()
+					{
+						if (!sink)
+						{
+							parseBlocks();
+							return;
+						}
+						
+						TelemetryScope scope(taskTelemetry[i]);
+						parseBlocks();
+					});
 				}
 				
-				memcpy(b.rotation, newRot, sizeof(b.rotation));
+				//the calling thread parses too
+				parseBlocks();
 				
-				f32 newSize[3]{};
-				in.read(rcast<char*>(&newSize[0]), sizeof(f32));
-				in.read(rcast<char*>(&newSize[1]), sizeof(f32));
-				in.read(rcast<char*>(&newSize[2]), sizeof(f32));
+				group.wait();
+			}
+			catch (...)
+			{
+				//a pool that failed to start or fewer queued tasks only make the parse slower,
+				//the group already waited for its tasks and the caller claims what is left
+				parseBlocks();
+			}
+		}
+		
+		for (const auto& t : taskTelemetry) sink->Add(t);
+		
+		//every block before the first failure was claimed before it, so all of them were parsed
+		size_t failure = firstFailure.load();
+		
+		return failure < modelCount
+			? results[order[failure]]
+			: ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Reads every block of the file with one read and parses them into Block values created by makeBlock,
+	//threadCount 0 uses one thread per MIN_PARSE_BYTES_PER_THREAD bytes up to one per hardware thread
+	template <typename Block, typename MakeBlock>
+	inline ImportResult ImportKMDWith(
+		const path& inFile,
+		ModelHeader& outHeader,
+		vector<ModelTable>& outTables,
+		vector<Block>& outBlocks,
+		MakeBlock&& makeBlock,
+		u32 threadCount,
+		ValidationMode mode)
+	{
+		KmdFile file{};
+		
+		ImportResult openResult = file.Open(inFile, mode);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		const ModelHeader& header = file.GetHeader();
+		
+		try
+		{
+			//read in the size of all models with one read, starting at the end of the tables,
+			//the read starts at an aligned file offset so blocks of padded files stay aligned in memory
+			
+			size_t blockRegionEnd = GetHeaderSize(header.version) + header.modelTablesSize + header.modelBlocksSize;
+			size_t blockRegionStart = GetHeaderSize(header.version) + header.modelTablesSize;
+			blockRegionStart -= blockRegionStart % MODEL_BLOCK_ALIGNMENT;
+			
+			vector<u8> blockData(blockRegionEnd - blockRegionStart);
+			
+			AddTelemetry(&LoadTelemetry::allocationCount, 1);
+			AddTelemetry(&LoadTelemetry::allocationBytes, blockData.size());
+			
+			ImportResult readResult{};
+			{
+				PhaseTimer ioTimer(LoadPhase::PHASE_BLOCK_IO);
 				
-				if (newSize[0] < MIN_SIZE
-					|| newSize[0] > MAX_SIZE
-					|| newSize[1] < MIN_SIZE
-					|| newSize[1] > MAX_SIZE
-					|| newSize[2] < MIN_SIZE
-					|| newSize[2] > MAX_SIZE)
+				readResult = file.ReadBytes(
+					blockRegionStart,
+					blockData.size(),
+					blockData.data());
+			}
+			
+			if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+			
+			//model block data
+			
+			const vector<ModelTable>& tables = file.GetTables();
+			
+			vector<Block> blocks{};
+			blocks.reserve(tables.size());
+			for (size_t i = 0; i < tables.size(); i++) blocks.push_back(makeBlock());
+			
+			if (threadCount == 0)
+			{
+				threadCount = min(
+					max(thread::hardware_concurrency(), 1u),
+					scast<u32>(blockData.size() / MIN_PARSE_BYTES_PER_THREAD) + 1);
+			}
+			threadCount = min(threadCount, max(scast<u32>(tables.size()), 1u));
+			
+			PhaseTimer parseTimer(LoadPhase::PHASE_BLOCK_PARSE);
+			
+			ImportResult blockResult = ParseBlocksParallel(
+				blockData.data(),
+				blockData.size(),
+				blockRegionStart,
+				tables,
+				blocks,
+				threadCount,
+				mode,
+				file.GetChecksums());
+			
+			if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+			
+			outHeader = header;
+			outTables = file.GetTables();
+			outBlocks = move(blocks);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		catch (...)
+		{
+			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+		}
+	}
+	
+	//Returns the entire kmd file binary content in structs, blocks are validated and copied
+	//on threadCount threads, 0 picks the count from the size of the model blocks.
+	//A failed import returns the error of the first failing block in file order
+	inline ImportResult ImportKMD(
+		const path& inFile,
+		ModelHeader& outHeader,
+		vector<ModelTable>& outTables,
+		vector<ModelBlock>& outBlocks,
+		u32 threadCount = 0,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+	{
+		return ImportKMDWith(
+			inFile,
+			outHeader,
+			outTables,
+			outBlocks,
+			[] { return ModelBlock{}; },
+			threadCount,
+			mode);
+	}
+	
+	//Returns the entire kmd file binary content in structs with every vertex and index array
+	//allocated from resource instead of the global heap, pass a monotonic_buffer_resource over
+	//a buffer of at least modelBlocksSize bytes to place all geometry in that one buffer.
+	//Parses on one thread by default, resource must be thread-safe for any other threadCount
+	inline ImportResult ImportKMD(
+		const path& inFile,
+		ModelHeader& outHeader,
+		vector<ModelTable>& outTables,
+		vector<PmrModelBlock>& outBlocks,
+		memory_resource* resource,
+		u32 threadCount = 1,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+	{
+		return ImportKMDWith(
+			inFile,
+			outHeader,
+			outTables,
+			outBlocks,
+			[resource] { return MakePmrBlock(resource); },
+			threadCount,
+			mode);
+	}
+	
+	//
+	// SHARED HANDLE IMPORT
+	//
+	
+	//Kmd file that serves block reads from any number of threads through one OS file handle.
+	//Every read is positional and everything but the read buffers is immutable after Open,
+	//so reads take no locks
+	class KmdReader
+	{
+	public:
+		KmdReader() = default;
+		~KmdReader() { Close(); }
+		
+		KmdReader(const KmdReader&) = delete;
+		KmdReader& operator=(const KmdReader&) = delete;
+		
+		//Validates the file and loads its tables, mode picks how blocks are verified
+		//when they are read. Not thread-safe
+		ImportResult Open(
+			const path& inFile,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			Close();
+			
+			KmdFile kmd{};
+			
+			ImportResult openResult = kmd.Open(inFile, mode);
+			if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+			
+			header = kmd.GetHeader();
+			tables = kmd.GetTables();
+			tableBytes = kmd.GetTableBytes();
+			nameIndex = kmd.GetNameIndex();
+			checksums = kmd.GetChecksums();
+			validationMode = mode;
+			fileSize = kmd.GetFileSize();
+			
+			//block reads keep using the handle the tables were read through
+			file = kmd.ReleaseNativeFile();
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Not thread-safe, no reads may be in flight
+		void Close()
+		{
+			CloseNativeFile(file);
+			
+			header = {};
+			tables.clear();
+			tableBytes.clear();
+			nameIndex.clear();
+			checksums.clear();
+			fileSize = 0;
+		}
+		
+		bool IsOpen() const { return file != INVALID_NATIVE_FILE; }
+		
+		const ModelHeader& GetHeader() const { return header; }
+		const vector<ModelTable>& GetTables() const { return tables; }
+		size_t GetFileSize() const { return fileSize; }
+		NativeFile GetNativeFile() const { return file; }
+		
+		//Stored block checksums sorted by block offset, empty if the file has no valid checksum section
+		const vector<BlockChecksum>& GetChecksums() const { return checksums; }
+		ValidationMode GetValidationMode() const { return validationMode; }
+		
+		//Returns the table of the first model with this node name or nullptr if there is none
+		const ModelTable* FindModel(string_view name) const
+		{
+			u32 index{};
+			if (!FindModelIndex(
+				tableBytes.data(),
+				scast<u32>(tables.size()),
+				nameIndex,
+				name,
+				index,
+				header.version))
+			{
+				return nullptr;
+			}
+			
+			return &tables[index];
+		}
+		
+		//Reads and parses one block, safe to call from any thread
+		ImportResult ReadBlock(
+			const ModelTable& table,
+			ModelBlock& outBlock) const
+		{
+			ModelBlock b{};
+			
+			ImportResult blockResult = ReadBlock(
+				table,
+				GetScratch(),
+				b);
+			
+			if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+			
+			outBlock = move(b);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Returns model blocks for the inserted tables, safe to call from any thread
+		ImportResult ReadBlocks(
+			const vector<ModelTable>& inTables,
+			vector<ModelBlock>& outBlocks) const
+		{
+			return ReadBlocksWith(
+				inTables,
+				outBlocks,
+				[] { return ModelBlock{}; });
+		}
+		
+		//Returns model blocks for the inserted tables with vertices and indices allocated
+		//from resource, safe to call from any thread if resource is
+		ImportResult ReadBlocks(
+			const vector<ModelTable>& inTables,
+			vector<PmrModelBlock>& outBlocks,
+			memory_resource* resource) const
+		{
+			return ReadBlocksWith(
+				inTables,
+				outBlocks,
+				[resource] { return MakePmrBlock(resource); });
+		}
+	
+	private:
+		NativeFile file = INVALID_NATIVE_FILE;
+		size_t fileSize{};
+		
+		ModelHeader header{};
+		vector<ModelTable> tables{};
+		vector<u8> tableBytes{};
+		vector<u8> nameIndex{};
+		
+		vector<BlockChecksum> checksums{};
+		ValidationMode validationMode{};
+		
+		//Each thread keeps its own buffer, it only grows to the largest block it has read
+		static vector<u8>& GetScratch()
+		{
+			thread_local vector<u8> scratch{};
+			return scratch;
+		}
+		
+		template <typename Block>
+		ImportResult ReadBlock(
+			const ModelTable& table,
+			vector<u8>& buffer,
+			Block& outBlock) const
+		{
+			//verify that block size is not OOB
+			if (!IsInsideRegion(table.blockOffset, table.blockSize, 0, fileSize)) return ImportResult::RESULT_UNEXPECTED_EOF;
+			
+			try
+			{
+				if (buffer.size() < table.blockSize)
 				{
-					return ImportResult::RESULT_INVALID_MODEL_SIZE;
+					AddTelemetry(&LoadTelemetry::allocationCount, 1);
+					AddTelemetry(&LoadTelemetry::allocationBytes, table.blockSize);
+					
+					buffer.resize(table.blockSize);
 				}
 				
-				memcpy(b.size, newSize, sizeof(b.size));
-				
-				in.read(rcast<char*>(&b.verticesOffset), sizeof(u32));
-				in.read(rcast<char*>(&b.verticesSize),   sizeof(u32));
-				in.read(rcast<char*>(&b.indicesOffset),  sizeof(u32));
-				in.read(rcast<char*>(&b.indicesSize),    sizeof(u32));
-				
-				//verify that vertices are not OOB
-				if (offset + VERTICE_DATA_OFFSET + b.verticesSize > fileSize)
+				ImportResult readResult{};
 				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
+					PhaseTimer ioTimer(LoadPhase::PHASE_BLOCK_IO);
+					
+					readResult = ReadFileAt(
+						file,
+						table.blockOffset,
+						table.blockSize,
+						buffer.data());
 				}
 				
-				//vertices
+				if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
 				
-				size_t vertexCount = b.verticesSize / sizeof(Vertex);
+				PhaseTimer parseTimer(LoadPhase::PHASE_BLOCK_PARSE);
 				
-				b.vertices.resize(vertexCount);
-				in.read(rcast<char*>(b.vertices.data()), b.verticesSize);
+				return ParseBlockInto(
+					buffer.data(),
+					table.blockSize,
+					outBlock,
+					validationMode,
+					FindBlockChecksum(checksums, table.blockOffset));
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+		}
+		
+		//Reads the blocks into Block values created by makeBlock and parsed in place
+		template <typename Block, typename MakeBlock>
+		ImportResult ReadBlocksWith(
+			const vector<ModelTable>& inTables,
+			vector<Block>& outBlocks,
+			MakeBlock&& makeBlock) const
+		{
+			vector<u8>& scratch = GetScratch();
+			
+			try
+			{
+				vector<Block> blocks{};
+				blocks.reserve(inTables.size());
 				
-				//verify that indices are not OOB
-				if (offset + VERTICE_DATA_OFFSET + b.verticesSize + b.indicesSize > fileSize)
+				for (const auto& t : inTables)
 				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
+					Block b = makeBlock();
+					
+					ImportResult blockResult = ReadBlock(
+						t,
+						scratch,
+						b);
+					
+					if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+					
+					blocks.push_back(move(b));
 				}
 				
-				//indices
+				outBlocks = move(blocks);
 				
-				size_t indexCount = b.indicesSize / sizeof(u32);
-				
-				b.indices.resize(indexCount);
-				in.read(rcast<char*>(b.indices.data()), b.indicesSize);
-				
-				blocks.push_back(move(b));
+				return ImportResult::RESULT_SUCCESS;
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+		}
+	};
+	
+	//
+	// MEMORY-MAPPED IMPORT
+	//
+	
+	//Indexed indirect draw arguments, laid out like VkDrawIndexedIndirectCommand
+	//and the OpenGL DrawElementsIndirectCommand so the array can be uploaded as is
+	struct DrawIndexedCommand
+	{
+		u32 indexCount{};
+		u32 instanceCount{};
+		u32 firstIndex{};
+		i32 baseVertex{};
+		u32 firstInstance{};
+	};
+	
+	//Buffer sizes MergeBlocks needs for a set of models
+	struct MergedSizes
+	{
+		u64 vertexCount{};
+		u64 indexCount{};
+		u32 commandCount{};
+	};
+	
+	//Non-owning view of one model block inside a MappedKMD,
+	//only valid for as long as its MappedKMD stays open
+	struct ModelBlockView
+	{
+		string_view nodeName{};
+		string_view meshName{};
+		string_view nodePath{};
+		u8 dataTypeFlags{};
+		u8 renderType{};
+		
+		f32 position[3]{}; //x, y, z (vector3)
+		f32 rotation[4]{}; //w, x, y, z (quaternion)
+		f32 size[3]{};     //x, y, z (vector3)
+		
+		span<const Vertex> vertices{};
+		span<const u32> indices{};
+	};
+	
+	//Validates the model block at blockData and points the view at its vertices and indices,
+	//blockData must stay alive and aligned to MODEL_BLOCK_ALIGNMENT for as long as the view is used
+	inline ImportResult ParseBlockView(
+		const u8* blockData,
+		size_t blockSize,
+		ModelBlockView& outView,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT,
+		const u32* checksum = nullptr)
+	{
+		if (blockSize < VERTICE_DATA_OFFSET) return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
+		
+		bool isCheckingFields{};
+		
+		ImportResult checksumResult = VerifyBlockChecksum(
+			blockData,
+			blockSize,
+			mode,
+			checksum,
+			isCheckingFields);
+		
+		if (checksumResult != ImportResult::RESULT_SUCCESS) return checksumResult;
+		
+		ModelBlockView v{};
+		
+		v.nodeName = FixedNameView(blockData + 0, 20);
+		v.meshName = FixedNameView(blockData + 20, 20);
+		v.nodePath = FixedNameView(blockData + 40, 50);
+		
+		v.dataTypeFlags = blockData[90];
+		v.renderType = blockData[91];
+		
+		memcpy(v.position, blockData + 92, sizeof(v.position));
+		memcpy(v.rotation, blockData + 104, sizeof(v.rotation));
+		memcpy(v.size, blockData + 120, sizeof(v.size));
+		
+		if (isCheckingFields)
+		{
+			ImportResult fieldResult = ValidateBlockFields(
+				v.dataTypeFlags,
+				v.renderType,
+				v.position,
+				v.rotation,
+				v.size);
+			
+			if (fieldResult != ImportResult::RESULT_SUCCESS) return fieldResult;
+		}
+		
+		u32 verticesSize{};
+		u32 indicesSize{};
+		memcpy(&verticesSize, blockData + 136, sizeof(u32));
+		memcpy(&indicesSize,  blockData + 144, sizeof(u32));
+		
+		//verify that vertices and indices are not OOB
+		if (scast<size_t>(VERTICE_DATA_OFFSET) + verticesSize + indicesSize > blockSize)
+		{
+			return ImportResult::RESULT_UNEXPECTED_EOF;
+		}
+		
+		const u8* verticesData = blockData + VERTICE_DATA_OFFSET;
+		const u8* indicesData = verticesData + verticesSize;
+		
+		if (mode == ValidationMode::VALIDATION_PARANOID
+			&& !IsValidBlockPayload(
+				verticesData,
+				verticesSize / sizeof(Vertex),
+				indicesData,
+				indicesSize / sizeof(u32)))
+		{
+			return ImportResult::RESULT_INVALID_VERTEX_DATA;
+		}
+		
+		v.vertices = span<const Vertex>(
+			rcast<const Vertex*>(verticesData),
+			verticesSize / sizeof(Vertex));
+		v.indices = span<const u32>(
+			rcast<const u32*>(indicesData),
+			indicesSize / sizeof(u32));
+		
+		outView = v;
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Memory-maps a kmd file and validates it once on open, model blocks are returned as
+	//views straight into the mapping so vertices and indices can be uploaded without copies
+	class MappedKMD
+	{
+	public:
+		MappedKMD() = default;
+		~MappedKMD() { Close(); }
+		
+		MappedKMD(const MappedKMD&) = delete;
+		MappedKMD& operator=(const MappedKMD&) = delete;
+		
+		//Maps and validates the file, mode picks how its blocks are verified
+		ImportResult Open(
+			const path& inFile,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			Close();
+			
+			validationMode = mode;
+			
+			ImportResult preReadResult = PreReadCheck(inFile);
+			if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+			
+			AddTelemetry(&LoadTelemetry::openCount, 1);
+			
+			ImportResult mapResult{};
+			{
+				PhaseTimer openTimer(LoadPhase::PHASE_OPEN);
+				mapResult = Map(inFile);
+			}
+			
+			if (mapResult != ImportResult::RESULT_SUCCESS)
+			{
+				Close();
+				return mapResult;
+			}
+			
+			//the header, tables and block views are validated in one pass over the mapping
+			ImportResult parseResult{};
+			{
+				PhaseTimer parseTimer(LoadPhase::PHASE_BLOCK_PARSE);
+				parseResult = Parse();
+			}
+			
+			if (parseResult != ImportResult::RESULT_SUCCESS)
+			{
+				Close();
+				return parseResult;
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		void Close()
+		{
+			views.clear();
+			header = {};
+			tableData = nullptr;
+			nameIndex = {};
+			data = nullptr;
+			dataSize = 0;
+			
+			vector<u8>().swap(shiftedCopy);
+			
+#ifdef _WIN32
+			if (mapping) UnmapViewOfFile(mapping);
+			if (mappingHandle) CloseHandle(mappingHandle);
+			if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+			
+			mappingHandle = nullptr;
+			fileHandle = INVALID_HANDLE_VALUE;
+#else
+			if (mapping) munmap(mapping, mappingSize);
+#endif
+			mapping = nullptr;
+			mappingSize = 0;
+		}
+		
+		bool IsOpen() const { return data != nullptr; }
+		
+		const ModelHeader& GetHeader() const { return header; }
+		
+		span<const ModelBlockView> GetBlocks() const { return views; }
+		
+		//Returns the view of the first model with this node name or nullptr if there is none,
+		//files with a name index are searched in O(log n) straight from the mapped table
+		const ModelBlockView* FindModel(string_view name) const
+		{
+			u32 index{};
+			if (!FindModelIndex(
+				tableData,
+				header.modelCount,
+				nameIndex,
+				name,
+				index,
+				header.version))
+			{
+				return nullptr;
 			}
 			
-			in.close();
+			return &views[index];
+		}
+		
+		//Returns the buffer sizes MergeBlocks needs for modelIndices, an empty modelIndices selects
+		//every model in file order. Fails if the indices don't fit the u32 firstIndex of a draw command
+		//or the vertices the i32 baseVertex, since the offsets would be cut off
+		ImportResult GetMergedSizes(
+			span<const u32> modelIndices,
+			MergedSizes& outSizes) const
+		{
+			MergedSizes sizes{};
 			
-			outBlocks = move(blocks);
+			ImportResult result = ForEachSelected(
+				modelIndices,
+				[&sizes](const ModelBlockView& v)
+				{
+					sizes.vertexCount += v.vertices.size();
+					sizes.indexCount += v.indices.size();
+					sizes.commandCount++;
+				});
+			
+			if (result != ImportResult::RESULT_SUCCESS) return result;
+			
+			if (sizes.indexCount > UINT32_MAX
+				|| sizes.vertexCount > scast<u64>(INT32_MAX))
+			{
+				return ImportResult::RESULT_MERGE_TOO_LARGE;
+			}
+			
+			outSizes = sizes;
 			
 			return ImportResult::RESULT_SUCCESS;
 		}
-		catch(...)
+		
+		//Copies the vertices and indices of modelIndices back to back into the caller's buffers,
+		//which can be mapped GPU memory, and writes one indirect draw command per model.
+		//Indices stay relative to their own model and are offset by baseVertex when drawn,
+		//firstInstance holds the command index so shaders can look up per-model data with it
+		ImportResult MergeBlocks(
+			span<const u32> modelIndices,
+			span<Vertex> outVertices,
+			span<u32> outIndices,
+			span<DrawIndexedCommand> outCommands) const
 		{
-			return ImportResult::RESULT_UNEXPECTED_EOF;
+			MergedSizes sizes{};
+			
+			ImportResult sizeResult = GetMergedSizes(modelIndices, sizes);
+			if (sizeResult != ImportResult::RESULT_SUCCESS) return sizeResult;
+			
+			if (sizes.vertexCount > outVertices.size()
+				|| sizes.indexCount > outIndices.size()
+				|| sizes.commandCount > outCommands.size())
+			{
+				return ImportResult::RESULT_BUFFER_TOO_SMALL;
+			}
+			
+			u64 vertexOffset{};
+			u64 indexOffset{};
+			u32 commandIndex{};
+			
+			return ForEachSelected(
+				modelIndices,
+				[&](const ModelBlockView& v)
+				{
+					memcpy(outVertices.data() + vertexOffset, v.vertices.data(), v.vertices.size_bytes());
+					memcpy(outIndices.data() + indexOffset, v.indices.data(), v.indices.size_bytes());
+					
+					DrawIndexedCommand& c = outCommands[commandIndex];
+					c.indexCount = scast<u32>(v.indices.size());
+					c.instanceCount = 1;
+					c.firstIndex = scast<u32>(indexOffset);
+					c.baseVertex = scast<i32>(vertexOffset);
+					c.firstInstance = commandIndex;
+					
+					vertexOffset += v.vertices.size();
+					indexOffset += v.indices.size();
+					commandIndex++;
+				});
 		}
-	}
 	
-	//Returns the entire kmd file binary content in structs
-	inline ImportResult ImportKMD(
-		const path& inFile,
-		ModelHeader& outHeader,
-		vector<ModelTable>& outTables,
-		vector<ModelBlock>& outBlocks)
-	{
-		ImportResult preReadResult = PreReadCheck(inFile);
-		if (preReadResult != ImportResult::RESULT_SUCCESS) return preReadResult;
+	private:
+		const u8* data{};
+		size_t dataSize{};
 		
-		ImportResult tryOpenResult = TryOpenCheck(inFile);
-		if (tryOpenResult != ImportResult::RESULT_SUCCESS) return tryOpenResult;
+		void* mapping{};
+		size_t mappingSize{};
+		
+#ifdef _WIN32
+		HANDLE fileHandle = INVALID_HANDLE_VALUE;
+		HANDLE mappingHandle{};
+#endif
+		
+		//only used for files whose blocks are not aligned to MODEL_BLOCK_ALIGNMENT
+		vector<u8> shiftedCopy{};
 		
-		//header data
-			
 		ModelHeader header{};
+		vector<ModelBlockView> views{};
+		
+		//mapped model tables and name index payload for FindModel
+		const u8* tableData{};
+		span<const u8> nameIndex{};
+		
+		ValidationMode validationMode{};
+		
+		template <typename F>
+		ImportResult ForEachSelected(
+			span<const u32> modelIndices,
+			F&& func) const
+		{
+			if (modelIndices.empty())
+			{
+				for (const auto& v : views) func(v);
+				return ImportResult::RESULT_SUCCESS;
+			}
 			
-		ImportResult headerResult = GetHeaderData(
-			inFile,
-			header,
-			false);
+			for (u32 index : modelIndices)
+			{
+				if (index >= views.size()) return ImportResult::RESULT_INVALID_MODEL_COUNT;
+			}
+			for (u32 index : modelIndices) func(views[index]);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		ImportResult Map(const path& inFile)
+		{
+#ifdef _WIN32
+			fileHandle = CreateFileW(
+				inFile.wstring().c_str(),
+				GENERIC_READ,
+				FILE_SHARE_READ,
+				nullptr,
+				OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL,
+				nullptr);
 			
-		if (headerResult != ImportResult::RESULT_SUCCESS) return headerResult;
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				return GetLastError() == ERROR_SHARING_VIOLATION
+					? ImportResult::RESULT_FILE_LOCKED
+					: ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
 			
-		//model table data
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(fileHandle, &fileSize)) return ImportResult::RESULT_UNKNOWN_READ_ERROR;
 			
-		vector<ModelTable> tables{};
-		tables.reserve(header.modelCount);
+			mappingSize = scast<size_t>(fileSize.QuadPart);
+#else
+			int fd = open(inFile.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return errno == EBUSY
+					|| errno == ETXTBSY
+					? ImportResult::RESULT_FILE_LOCKED
+					: ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
 			
-		ImportResult tableResult = GetTableData(
-			inFile,
-			tables,
-			true);
+			struct stat fileStat{};
+			if (fstat(fd, &fileStat) != 0)
+			{
+				close(fd);
+				return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+			
+			mappingSize = scast<size_t>(fileStat.st_size);
+#endif
+			
+			if (mappingSize == 0)
+			{
+#ifndef _WIN32
+				close(fd);
+#endif
+				return ImportResult::RESULT_FILE_EMPTY;
+			}
+			//the max size depends on the version, Parse checks it once the header is read
+			if (mappingSize < MIN_TOTAL_SIZE)
+			{
+#ifndef _WIN32
+				close(fd);
+#endif
+				return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
+			}
+			
+#ifdef _WIN32
+			mappingHandle = CreateFileMappingW(
+				fileHandle,
+				nullptr,
+				PAGE_READONLY,
+				0,
+				0,
+				nullptr);
+			
+			if (!mappingHandle) return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			
+			mapping = MapViewOfFile(
+				mappingHandle,
+				FILE_MAP_READ,
+				0,
+				0,
+				0);
+			
+			if (!mapping) return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+#else
+			void* mapped = mmap(
+				nullptr,
+				mappingSize,
+				PROT_READ,
+				MAP_PRIVATE,
+				fd,
+				0);
+			
+			//the mapping stays valid after the descriptor is closed
+			close(fd);
 			
-		if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
+			if (mapped == MAP_FAILED) return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			
+			mapping = mapped;
+#endif
+			
+			data = scast<const u8*>(mapping);
+			dataSize = mappingSize;
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
 		
-		try
+		ImportResult Parse()
 		{
-			ifstream in(inFile, ios::in | ios::binary);
+			ImportResult headerResult = ParseHeader(data, header);
+			if (headerResult != ImportResult::RESULT_SUCCESS) return headerResult;
 			
-			vector<u8> blockData(header.modelBlocksSize);
+			if (header.version == KMD_VERSION
+				&& dataSize > MAX_TOTAL_SIZE)
+			{
+				return ImportResult::RESULT_UNSUPPORTED_FILE_SIZE;
+			}
 			
-			//start at the end of the tables
+			size_t headerSize = GetHeaderSize(header.version);
 			
-			size_t blockRegionStart = CORRECT_MODEL_HEADER_SIZE + header.modelTablesSize;
-			in.seekg(blockRegionStart);
+			if (header.modelCount == 0
+				|| header.modelTablesSize != scast<u64>(header.modelCount) * GetTableSize(header.version))
+			{
+				return ImportResult::RESULT_INVALID_MODEL_TABLE_SIZE;
+			}
 			
-			//read in the size of all models
-			in.read(
-				rcast<char*>(blockData.data()),
-				scast<streamsize>(header.modelBlocksSize));
-				
-			in.close();
+			size_t blockRegionStart = headerSize + header.modelTablesSize;
 			
-			//model block data
+			if (blockRegionStart > dataSize
+				|| header.modelBlocksSize > dataSize - blockRegionStart)
+			{
+				return ImportResult::RESULT_UNEXPECTED_EOF;
+			}
+			
+			tableData = data + headerSize;
 			
-			vector<ModelBlock> blocks{};
-			blocks.reserve(header.modelCount);
+			//blocks all share the same alignment because their sizes are multiples of 4,
+			//files from exporters that didn't pad the block region are copied once shifted
+			//so the views never point to misaligned vertices or indices
+			ModelTable first{};
+			ReadModelTable(tableData, 0, header, first);
 			
-			for (const auto& t : tables)
+			u64 firstOffset = first.blockOffset;
+			
+			size_t misalignment = firstOffset % MODEL_BLOCK_ALIGNMENT;
+			if (misalignment != 0)
 			{
-				ModelBlock b{};
-				size_t relativeOffset = t.blockOffset - blockRegionStart;
+				size_t shift = MODEL_BLOCK_ALIGNMENT - misalignment;
 				
-				//verify that block size is not OOB
-				if (relativeOffset + t.blockSize > blockData.size())
-				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
-				}
+				shiftedCopy.resize(dataSize + shift);
+				memcpy(shiftedCopy.data() + shift, data, dataSize);
 				
-				memcpy(b.nodeName, blockData.data() + relativeOffset + 0, 20);
-				memcpy(b.meshName, blockData.data() + relativeOffset + 20, 20);
-				memcpy(b.nodePath, blockData.data() + relativeOffset + 40, 50);
-				
-				//data flags go from 0 to 4
-				memcpy(&b.dataTypeFlags, blockData.data() + relativeOffset + 90, sizeof(u8));
-				if (b.dataTypeFlags & ~0b00011111) return ImportResult::RESULT_INVALID_DATA_FLAGS;
-				
-				//render type goes from 0 to 2
-				memcpy(&b.renderType, blockData.data() + relativeOffset + 91, sizeof(u8));
-				if (b.renderType > 2) return ImportResult::RESULT_INVALID_RENDER_TYPE;
-				
-				f32 newPos[3]{};
-				memcpy(&newPos[0], blockData.data() + relativeOffset + 92, sizeof(f32));
-				memcpy(&newPos[1], blockData.data() + relativeOffset + 96, sizeof(f32));
-				memcpy(&newPos[2], blockData.data() + relativeOffset + 100, sizeof(f32));
-				
-				if (newPos[0] < MIN_POS
-					|| newPos[0] > MAX_POS
-					|| newPos[1] < MIN_POS
-					|| newPos[1] > MAX_POS
-					|| newPos[2] < MIN_POS
-					|| newPos[2] > MAX_POS)
-				{
-					return ImportResult::RESULT_INVALID_MODEL_POSITION;
-				}
+				data = shiftedCopy.data() + shift;
+				tableData = data + headerSize;
+			}
+			
+			size_t blockRegionEnd = blockRegionStart + header.modelBlocksSize;
+			
+			span<const u8> payload{};
+			if (FindSection(
+					data + blockRegionEnd,
+					min(dataSize - blockRegionEnd, GetMaxTrailingSize(header.modelCount)),
+					NAME_INDEX_TAG,
+					payload)
+				&& IsValidNameIndex(payload, header.modelCount))
+			{
+				nameIndex = payload;
+			}
+			
+			//checksums are stored in table order, sections without one per model are ignored
+			span<const u8> checksums{};
+			if (FindSection(
+					data + blockRegionEnd,
+					min(dataSize - blockRegionEnd, GetMaxTrailingSize(header.modelCount)),
+					CHECKSUM_TAG,
+					payload)
+				&& payload.size() == scast<size_t>(header.modelCount) * sizeof(u32))
+			{
+				checksums = payload;
+			}
+			
+			views.resize(header.modelCount);
+			
+			for (u32 i = 0; i < header.modelCount; i++)
+			{
+				ModelTable t{};
 				
-				memcpy(b.position, newPos, sizeof(b.position));
-				
-				f32 newRot[4]{};
-				memcpy(&newRot[0], blockData.data() + relativeOffset + 104, sizeof(f32));
-				memcpy(&newRot[1], blockData.data() + relativeOffset + 108, sizeof(f32));
-				memcpy(&newRot[2], blockData.data() + relativeOffset + 112, sizeof(f32));
-				memcpy(&newRot[3], blockData.data() + relativeOffset + 116, sizeof(f32));
-				
-				if (newRot[0] < MIN_ROT
-					|| newRot[0] > MAX_ROT
-					|| newRot[1] < MIN_ROT
-					|| newRot[1] > MAX_ROT
-					|| newRot[2] < MIN_ROT
-					|| newRot[2] > MAX_ROT
-					|| newRot[3] < MIN_ROT
-					|| newRot[3] > MAX_ROT)
-				{
-					return ImportResult::RESULT_INVALID_MODEL_ROTATION;
-				}
+				//ReadModelTable rejects blocks outside the block region
+				ImportResult tableResult = ReadModelTable(
+					tableData,
+					i,
+					header,
+					t);
 				
-				memcpy(b.rotation, newRot, sizeof(b.rotation));
+				if (tableResult != ImportResult::RESULT_SUCCESS) return tableResult;
 				
-				f32 newSize[3]{};
-				memcpy(&newSize[0], blockData.data() + relativeOffset + 120, sizeof(f32));
-				memcpy(&newSize[1], blockData.data() + relativeOffset + 124, sizeof(f32));
-				memcpy(&newSize[2], blockData.data() + relativeOffset + 128, sizeof(f32));
+				u64 blockOffset = t.blockOffset;
+				u32 blockSize = t.blockSize;
 				
-				if (newSize[0] < MIN_SIZE
-					|| newSize[0] > MAX_SIZE
-					|| newSize[1] < MIN_SIZE
-					|| newSize[1] > MAX_SIZE
-					|| newSize[2] < MIN_SIZE
-					|| newSize[2] > MAX_SIZE)
+				if (blockOffset % MODEL_BLOCK_ALIGNMENT != firstOffset % MODEL_BLOCK_ALIGNMENT)
 				{
-					return ImportResult::RESULT_INVALID_MODEL_SIZE;
+					return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
 				}
 				
-				memcpy(b.size, newSize, sizeof(b.size));
+				u32 checksum{};
+				if (!checksums.empty()) memcpy(&checksum, checksums.data() + i * sizeof(u32), sizeof(u32));
 				
-				memcpy(&b.verticesOffset, blockData.data() + relativeOffset + 132, sizeof(u32));
-				memcpy(&b.verticesSize,   blockData.data() + relativeOffset + 136, sizeof(u32));
-				memcpy(&b.indicesOffset,  blockData.data() + relativeOffset + 140, sizeof(u32));
-				memcpy(&b.indicesSize,    blockData.data() + relativeOffset + 144, sizeof(u32));
+				ImportResult blockResult = ParseBlockView(
+					data + blockOffset,
+					blockSize,
+					views[i],
+					validationMode,
+					checksums.empty() ? nullptr : &checksum);
 				
-				//verify that vertices are not OOB
-				if (relativeOffset + scast<u32>(VERTICE_DATA_OFFSET) + b.verticesSize > blockData.size())
-				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
-				}
-				
-				//vertices
-				
-				size_t vertexCount = b.verticesSize / sizeof(Vertex);
+				if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+			}
+			
+			AddTelemetry(&LoadTelemetry::blocksDecoded, header.modelCount);
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+	};
+	
+	//
+	// CUSTOM VERTEX LAYOUTS
+	//
+	
+	//Component type an attribute is written as, normalized types clamp to their range
+	enum class ComponentType : u8
+	{
+		FLOAT32 = 0,
+		FLOAT16 = 1,
+		SNORM16 = 2, //-1 to 1
+		UNORM16 = 3, //0 to 1
+		SNORM8  = 4, //-1 to 1
+		UNORM8  = 5  //0 to 1
+	};
+	
+	//Where and how one vertex attribute is stored in the destination vertex,
+	//count is how many of the source components are written, starting from the first
+	struct AttributeLayout
+	{
+		u32 offset{};
+		ComponentType type{};
+		u8 count{};
+	};
+	
+	//Destination vertex layout, VertexType is the engine vertex struct and any of the static
+	//constexpr AttributeLayout members position (3), normal (3), texCoord (2) and tangent (4)
+	//select the attributes to write, attributes without a member are skipped
+	template <typename L>
+	concept VertexLayout = requires
+	{
+		typename L::VertexType;
+	}
+	&& is_trivially_copyable_v<typename L::VertexType>
+	&& is_default_constructible_v<typename L::VertexType>;
+	
+	//Returns value as a half float, rounded to nearest even
+	constexpr u16 FloatToHalf(f32 value)
+	{
+		u32 bits = bit_cast<u32>(value);
+		u32 sign = (bits >> 16) & 0x8000u;
+		i32 exponent = scast<i32>((bits >> 23) & 0xFFu) - 127 + 15;
+		u32 mantissa = bits & 0x7FFFFFu;
+		
+		//infinity and NaN
+		if (exponent == 128 + 15) return scast<u16>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+		
+		//overflow to infinity
+		if (exponent >= 31) return scast<u16>(sign | 0x7C00u);
+		
+		//subnormal half or underflow to zero
+		if (exponent <= 0)
+		{
+			if (exponent < -10) return scast<u16>(sign);
+			
+			mantissa |= 0x800000u;
+			
+			u32 shift = scast<u32>(14 - exponent);
+			u32 half = mantissa >> shift;
+			u32 remainder = mantissa & ((1u << shift) - 1);
+			u32 midpoint = 1u << (shift - 1);
+			
+			if (remainder > midpoint
+				|| (remainder == midpoint && (half & 1u)))
+			{
+				half++;
+			}
+			
+			return scast<u16>(sign | half);
+		}
+		
+		//a rounding carry out of the mantissa correctly bumps the exponent
+		u32 half = (scast<u32>(exponent) << 10) | (mantissa >> 13);
+		u32 remainder = mantissa & 0x1FFFu;
+		
+		if (remainder > 0x1000u
+			|| (remainder == 0x1000u && (half & 1u)))
+		{
+			half++;
+		}
+		
+		return scast<u16>(sign | half);
+	}
+	
+	constexpr u32 GetComponentSize(ComponentType type)
+	{
+		switch (type)
+		{
+		case ComponentType::FLOAT32: return 4;
+		case ComponentType::FLOAT16:
+		case ComponentType::SNORM16:
+		case ComponentType::UNORM16: return 2;
+		case ComponentType::SNORM8:
+		case ComponentType::UNORM8:  return 1;
+		}
+		
+		return 0;
+	}
+	
+	//Rounds the clamped value to the nearest normalized integer, NaN becomes 0
+	//since it fails both comparisons and casting it to an integer is undefined
+	template <typename T>
+	constexpr T ToNormalized(
+		f32 value,
+		f32 minValue,
+		f32 scale)
+	{
+		if (value != value) return T{};
+		
+		f32 clamped = value < minValue ? minValue : (value > 1.0f ? 1.0f : value);
+		f32 scaled = clamped * scale;
+		
+		return scast<T>(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+	}
+	
+	template <AttributeLayout A>
+	inline void WriteAttribute(
+		u8* vertexData,
+		const f32* source)
+	{
+		u8* out = vertexData + A.offset;
+		
+		for (u32 i = 0; i < A.count; i++)
+		{
+			if constexpr (A.type == ComponentType::FLOAT32)
+			{
+				memcpy(out + i * 4, &source[i], 4);
+			}
+			else if constexpr (A.type == ComponentType::FLOAT16)
+			{
+				u16 value = FloatToHalf(source[i]);
+				memcpy(out + i * 2, &value, 2);
+			}
+			else if constexpr (A.type == ComponentType::SNORM16)
+			{
+				i16 value = ToNormalized<i16>(source[i], -1.0f, 32767.0f);
+				memcpy(out + i * 2, &value, 2);
+			}
+			else if constexpr (A.type == ComponentType::UNORM16)
+			{
+				u16 value = ToNormalized<u16>(source[i], 0.0f, 65535.0f);
+				memcpy(out + i * 2, &value, 2);
+			}
+			else if constexpr (A.type == ComponentType::SNORM8)
+			{
+				out[i] = bit_cast<u8>(ToNormalized<i8>(source[i], -1.0f, 127.0f));
+			}
+			else
+			{
+				out[i] = ToNormalized<u8>(source[i], 0.0f, 255.0f);
+			}
+		}
+	}
+	
+	template <typename V, AttributeLayout A, u32 SourceCount>
+	constexpr bool IsValidAttribute()
+	{
+		return A.count > 0
+			&& A.count <= SourceCount
+			&& A.offset + A.count * GetComponentSize(A.type) <= sizeof(V);
+	}
+	
+	//Appends count kmd vertices at source to out in the layout of L. Each vertex is built on the
+	//stack and pushed once, so the destination is written in a single pass instead of being
+	//zero filled by a resize first. The loop is generated per layout so the attribute writes are known at compile time
+	template <VertexLayout L>
+	inline void ConvertVertices(
+		const u8* source,
+		size_t count,
+		vector<typename L::VertexType>& out)
+	{
+		using V = typename L::VertexType;
+		
+		out.reserve(out.size() + count);
+		
+		for (size_t i = 0; i < count; i++)
+		{
+			f32 in[sizeof(Vertex) / sizeof(f32)];
+			memcpy(in, source + i * sizeof(Vertex), sizeof(Vertex));
+			
+			//bytes no attribute writes stay zero
+			V v{};
+			u8* vertexData = rcast<u8*>(&v);
+			
+			if constexpr (requires { L::position; })
+			{
+				static_assert(IsValidAttribute<V, L::position, 3>(), "position does not fit the vertex type");
+				WriteAttribute<L::position>(vertexData, in + 0);
+			}
+			if constexpr (requires { L::normal; })
+			{
+				static_assert(IsValidAttribute<V, L::normal, 3>(), "normal does not fit the vertex type");
+				WriteAttribute<L::normal>(vertexData, in + 3);
+			}
+			if constexpr (requires { L::texCoord; })
+			{
+				static_assert(IsValidAttribute<V, L::texCoord, 2>(), "texCoord does not fit the vertex type");
+				WriteAttribute<L::texCoord>(vertexData, in + 6);
+			}
+			if constexpr (requires { L::tangent; })
+			{
+				static_assert(IsValidAttribute<V, L::tangent, 4>(), "tangent does not fit the vertex type");
+				WriteAttribute<L::tangent>(vertexData, in + 8);
+			}
+			
+			out.push_back(v);
+		}
+	}
+	
+	//ModelBlock with vertices decoded into the layout of L
+	template <VertexLayout L>
+	struct ModelBlockAs
+	{
+		char nodeName[20]{}; //19 chars + null terminator
+		char meshName[20]{}; //19 chars + null terminator
+		char nodePath[50]{}; //49 chars + null terminator
+		u8 dataTypeFlags{};  //defines what kind of data was stored to this model data block
+		u8 renderType{};     //defines if this model is opaque, transparent or masked
+		
+		f32 position[3]{}; //x, y, z (vector3)
+		f32 rotation[4]{}; //w, x, y, z (quaternion)
+		f32 size[3]{};     //x, y, z (vector3)
+		
+		u32 verticesOffset{};
+		u32 verticesSize{}; //size of the kmd vertices in the file, not of the decoded vertices
+		u32 indicesOffset{};
+		u32 indicesSize{};
+		
+		vector<typename L::VertexType> vertices{};
+		vector<u32> indices{};
+	};
+	
+	//Parses and validates the model block at blockData, decoding its vertices into the layout of L
+	template <VertexLayout L>
+	inline ImportResult ParseBlockAs(
+		const u8* blockData,
+		size_t blockSize,
+		ModelBlockAs<L>& outBlock,
+		ValidationMode mode = ValidationMode::VALIDATION_DEFAULT,
+		const u32* checksum = nullptr)
+	{
+		ModelBlockAs<L> b{};
+		
+		bool isCheckingFields{};
+		
+		ImportResult checksumResult = VerifyBlockChecksum(
+			blockData,
+			blockSize,
+			mode,
+			checksum,
+			isCheckingFields);
+		
+		if (checksumResult != ImportResult::RESULT_SUCCESS) return checksumResult;
+		
+		ImportResult fieldResult = ParseBlockFields(
+			blockData,
+			blockSize,
+			b,
+			isCheckingFields);
+		
+		if (fieldResult != ImportResult::RESULT_SUCCESS) return fieldResult;
+		
+		if (mode == ValidationMode::VALIDATION_PARANOID
+			&& !IsValidBlockPayload(
+				blockData + VERTICE_DATA_OFFSET,
+				b.verticesSize / sizeof(Vertex),
+				blockData + VERTICE_DATA_OFFSET + b.verticesSize,
+				b.indicesSize / sizeof(u32)))
+		{
+			return ImportResult::RESULT_INVALID_VERTEX_DATA;
+		}
+		
+		ConvertVertices<L>(
+			blockData + VERTICE_DATA_OFFSET,
+			b.verticesSize / sizeof(Vertex),
+			b.vertices);
+		
+		AssignFromBytes(
+			b.indices,
+			blockData + VERTICE_DATA_OFFSET + b.verticesSize,
+			b.indicesSize / sizeof(u32));
+		
+		AddTelemetry(&LoadTelemetry::blocksDecoded, 1);
+		
+		outBlock = move(b);
+		
+		return ImportResult::RESULT_SUCCESS;
+	}
+	
+	//Returns model blocks for the inserted tables with vertices in the layout of L
+	template <VertexLayout L>
+	inline ImportResult StreamModelsAs(
+		const KmdReader& reader,
+		const vector<ModelTable>& inTables,
+		vector<ModelBlockAs<L>>& outBlocks)
+	{
+		try
+		{
+			vector<ModelBlockAs<L>> blocks(inTables.size());
+			vector<u8> buffer{};
+			
+			for (size_t i = 0; i < inTables.size(); i++)
+			{
+				const ModelTable& t = inTables[i];
 				
-				b.vertices.resize(vertexCount);
-				memcpy(b.vertices.data(), blockData.data() + relativeOffset + VERTICE_DATA_OFFSET, b.verticesSize);
+				//verify that block size is not OOB
+				if (!IsInsideRegion(t.blockOffset, t.blockSize, 0, reader.GetFileSize())) return ImportResult::RESULT_UNEXPECTED_EOF;
 				
-				//verify that indices are not OOB
-				if (relativeOffset + scast<u32>(VERTICE_DATA_OFFSET) + b.verticesSize + b.indicesSize > blockData.size())
-				{
-					return ImportResult::RESULT_UNEXPECTED_EOF;
-				}
+				if (buffer.size() < t.blockSize) buffer.resize(t.blockSize);
 				
-				//indices
+				ImportResult readResult = ReadFileAt(
+					reader.GetNativeFile(),
+					t.blockOffset,
+					t.blockSize,
+					buffer.data());
 				
-				size_t indexCount = b.indicesSize / sizeof(u32);
+				if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
 				
-				b.indices.resize(indexCount);
-				memcpy(b.indices.data(), blockData.data() + relativeOffset + VERTICE_DATA_OFFSET + b.verticesSize, b.indicesSize);
+				ImportResult blockResult = ParseBlockAs<L>(
+					buffer.data(),
+					t.blockSize,
+					blocks[i],
+					reader.GetValidationMode(),
+					FindBlockChecksum(reader.GetChecksums(), t.blockOffset));
 				
-				blocks.push_back(move(b));
+				if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
 			}
 			
-			outHeader = header;
-			outTables = move(tables);
 			outBlocks = move(blocks);
 			
 			return ImportResult::RESULT_SUCCESS;
 		}
 		catch (...)
 		{
-			return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			return ImportResult::RESULT_UNEXPECTED_EOF;
 		}
 	}
+	
+	//Opens the file for one call, keep a KmdReader open instead when streaming from it repeatedly
+	template <VertexLayout L>
+	inline ImportResult StreamModelsAs(
+		const path& inFile,
+		const vector<ModelTable>& inTables,
+		vector<ModelBlockAs<L>>& outBlocks)
+	{
+		KmdReader reader{};
+		
+		ImportResult openResult = reader.Open(inFile);
+		if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+		
+		return StreamModelsAs<L>(
+			reader,
+			inTables,
+			outBlocks);
+	}
 }
\ No newline at end of file
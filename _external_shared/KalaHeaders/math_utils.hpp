@@ -25,18 +25,21 @@
 #include <basetsd.h>
 #endif
 
+//libstdc++ only provides the float overloads in the global namespace
+#ifdef _WIN32
 using std::sinf;
 using std::cosf;
 using std::tanf;
 using std::sqrtf;
 using std::fabsf;
 using std::atan2f;
-using std::clamp;
-using std::min;
-using std::max;
 using std::fmodf;
 using std::powf;
 using std::floorf;
+#endif
+using std::clamp;
+using std::min;
+using std::max;
 
 //============================================================================
 //
@@ -0,0 +1,292 @@
+//------------------------------------------------------------------------------
+// reload_kmd.hpp
+//
+// Copyright (C) 2025 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - HotReloader for keeping loaded kmd files in sync with their regenerated versions on disk
+//   - per-block hashes so only the blocks that actually changed are parsed again
+//   - subscribers notified with the indices of the changed blocks
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <system_error>
+
+#include "import_kmd.hpp"
+
+namespace KalaHeaders::KalaModelData
+{
+	using std::function;
+	using std::filesystem::file_time_type;
+	using std::filesystem::last_write_time;
+	using std::filesystem::file_size;
+	using std::error_code;
+	
+	//Returns a 64-bit hash of the block bytes, eight bytes are mixed in at a time
+	inline u64 HashBlockBytes(
+		const u8* data,
+		size_t size)
+	{
+		constexpr u64 prime = 0x100000001B3ull;
+		
+		u64 hash = 0xCBF29CE484222325ull;
+		
+		size_t i{};
+		for (; i + sizeof(u64) <= size; i += sizeof(u64))
+		{
+			u64 word{};
+			memcpy(&word, data + i, sizeof(u64));
+			
+			hash = (hash ^ word) * prime;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; i++) hash = (hash ^ data[i]) * prime;
+		
+		return hash;
+	}
+	
+	//Called after a file was reloaded with the indices of every block whose bytes changed or
+	//that did not exist before, blocks past the new model count were removed
+	using ReloadCallback = function<void(
+		u32 fileIndex,
+		span<const u32> changedIndices,
+		u32 modelCount)>;
+	
+	//Keeps every watched kmd loaded and reloads only the blocks that changed when a file is
+	//rewritten, call Poll from the tool loop. Not thread-safe, use one thread for all calls
+	class HotReloader
+	{
+	public:
+		//Loads every block of the file and starts watching it,
+		//mode picks how the blocks are verified on this and every later load
+		ImportResult Watch(
+			const path& inFile,
+			u32& outFileIndex,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			WatchedFile f{};
+			f.filePath = inFile;
+			f.validationMode = mode;
+			
+			ImportResult loadResult = Load(f);
+			if (loadResult != ImportResult::RESULT_SUCCESS) return loadResult;
+			
+			outFileIndex = scast<u32>(files.size());
+			files.push_back(move(f));
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Returns a subscriber id for Unsubscribe
+		u32 Subscribe(ReloadCallback callback)
+		{
+			subscribers.push_back({ nextSubscriberID, move(callback) });
+			return nextSubscriberID++;
+		}
+		
+		void Unsubscribe(u32 subscriberID)
+		{
+			std::erase_if(
+				subscribers,
+				[subscriberID](const Subscriber& s) { return s.id == subscriberID; });
+		}
+		
+		const ModelHeader& GetHeader(u32 fileIndex) const { return files[fileIndex].header; }
+		const vector<ModelTable>& GetTables(u32 fileIndex) const { return files[fileIndex].tables; }
+		const vector<ModelBlock>& GetBlocks(u32 fileIndex) const { return files[fileIndex].blocks; }
+		
+		//Reloads every watched file whose write time or size changed since it was last loaded,
+		//returns how many files were reloaded. Files that fail to load, such as files
+		//that are still being written, keep their current blocks and are retried on the next poll
+		u32 Poll()
+		{
+			u32 reloadedCount{};
+			
+			for (u32 i = 0; i < files.size(); i++)
+			{
+				WatchedFile& f = files[i];
+				
+				error_code ec{};
+				file_time_type writeTime = last_write_time(f.filePath, ec);
+				if (ec) continue;
+				
+				uintmax_t size = file_size(f.filePath, ec);
+				if (ec) continue;
+				
+				if (writeTime == f.writeTime
+					&& size == f.fileSize)
+				{
+					continue;
+				}
+				
+				if (Reload(i) == ImportResult::RESULT_SUCCESS) reloadedCount++;
+			}
+			
+			return reloadedCount;
+		}
+		
+		//Re-reads the header and tables of the file, hashes every block and parses only
+		//the blocks whose hash changed, subscribers are notified if any block changed
+		ImportResult Reload(u32 fileIndex)
+		{
+			WatchedFile& f = files[fileIndex];
+			
+			WatchedFile next{};
+			next.filePath = f.filePath;
+			next.validationMode = f.validationMode;
+			
+			vector<u32> changedIndices{};
+			
+			ImportResult loadResult = Load(
+				next,
+				&f,
+				&changedIndices);
+			
+			if (loadResult != ImportResult::RESULT_SUCCESS) return loadResult;
+			
+			//a new scale or a removed block changes the file even if no remaining block did
+			bool isFileChanged = next.blocks.size() != f.blocks.size()
+				|| next.header.scaleFactor != f.header.scaleFactor;
+			
+			f = move(next);
+			
+			if (!changedIndices.empty()
+				|| isFileChanged)
+			{
+				for (const auto& s : subscribers)
+				{
+					s.callback(
+						fileIndex,
+						changedIndices,
+						scast<u32>(f.blocks.size()));
+				}
+			}
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+	
+	private:
+		struct WatchedFile
+		{
+			path filePath{};
+			ValidationMode validationMode{};
+			file_time_type writeTime{};
+			uintmax_t fileSize{};
+			
+			ModelHeader header{};
+			vector<ModelTable> tables{};
+			vector<ModelBlock> blocks{};
+			vector<u64> blockHashes{};
+		};
+		
+		struct Subscriber
+		{
+			u32 id{};
+			ReloadCallback callback{};
+		};
+		
+		vector<WatchedFile> files{};
+		vector<Subscriber> subscribers{};
+		u32 nextSubscriberID = 1;
+		
+		//Loads outFile, blocks with the same index and hash as in previous are moved over
+		//instead of parsed, every other block index is added to outChangedIndices
+		static ImportResult Load(
+			WatchedFile& outFile,
+			WatchedFile* previous = nullptr,
+			vector<u32>* outChangedIndices = nullptr)
+		{
+			//the write time is taken first so a write that lands during the load triggers another one
+			error_code ec{};
+			outFile.writeTime = last_write_time(outFile.filePath, ec);
+			if (ec) return ImportResult::RESULT_FILE_NOT_FOUND;
+			
+			KmdReader reader{};
+			
+			ImportResult openResult = reader.Open(
+				outFile.filePath,
+				outFile.validationMode);
+			if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+			
+			outFile.fileSize = reader.GetFileSize();
+			outFile.header = reader.GetHeader();
+			outFile.tables = reader.GetTables();
+			
+			size_t modelCount = outFile.tables.size();
+			
+			try
+			{
+				outFile.blocks.resize(modelCount);
+				outFile.blockHashes.resize(modelCount);
+				
+				vector<u8> buffer{};
+				
+				for (size_t i = 0; i < modelCount; i++)
+				{
+					const ModelTable& t = outFile.tables[i];
+					
+					//verify that block size is not OOB
+					if (!IsInsideRegion(t.blockOffset, t.blockSize, 0, outFile.fileSize)) return ImportResult::RESULT_UNEXPECTED_EOF;
+					
+					if (buffer.size() < t.blockSize) buffer.resize(t.blockSize);
+					
+					ImportResult readResult = ReadFileAt(
+						reader.GetNativeFile(),
+						t.blockOffset,
+						t.blockSize,
+						buffer.data());
+					
+					if (readResult != ImportResult::RESULT_SUCCESS) return readResult;
+					
+					u64 hash = HashBlockBytes(buffer.data(), t.blockSize);
+					outFile.blockHashes[i] = hash;
+					
+					if (previous
+						&& i < previous->blockHashes.size()
+						&& previous->blockHashes[i] == hash)
+					{
+						continue;
+					}
+					
+					ImportResult blockResult = ParseBlock(
+						buffer.data(),
+						t.blockSize,
+						outFile.blocks[i],
+						reader.GetValidationMode(),
+						FindBlockChecksum(reader.GetChecksums(), t.blockOffset));
+					
+					if (blockResult != ImportResult::RESULT_SUCCESS) return blockResult;
+					
+					if (outChangedIndices) outChangedIndices->push_back(scast<u32>(i));
+				}
+				
+				//unchanged blocks are only moved over once the whole file loaded,
+				//so a failed reload leaves the previous blocks untouched
+				if (previous)
+				{
+					for (size_t i = 0; i < modelCount; i++)
+					{
+						if (i < previous->blockHashes.size()
+							&& previous->blockHashes[i] == outFile.blockHashes[i])
+						{
+							outFile.blocks[i] = move(previous->blocks[i]);
+						}
+					}
+				}
+				
+				return ImportResult::RESULT_SUCCESS;
+			}
+			catch (...)
+			{
+				return ImportResult::RESULT_UNKNOWN_READ_ERROR;
+			}
+		}
+	};
+}
\ No newline at end of file
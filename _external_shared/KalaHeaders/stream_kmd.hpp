@@ -0,0 +1,490 @@
+//------------------------------------------------------------------------------
+// stream_kmd.hpp
+//
+// Copyright (C) 2025 Lost Empire Entertainment
+//
+// This is free source code, and you are welcome to redistribute it under certain conditions.
+// Read LICENSE.md for more information.
+//
+// Provides:
+//   - StreamQueue for loading kmd model blocks asynchronously in priority order
+//   - Re-prioritizing and cancelling queued requests, completions through callbacks or futures
+//   - StreamStats with queue latency and read throughput of a StreamQueue
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "import_kmd.hpp"
+
+namespace KalaHeaders::KalaModelData
+{
+	using std::deque;
+	using std::map;
+	using std::unordered_map;
+	using std::pair;
+	using std::function;
+	using std::future;
+	using std::promise;
+	using std::shared_ptr;
+	using std::make_shared;
+	using std::mutex;
+	using std::scoped_lock;
+	using std::unique_lock;
+	using std::condition_variable;
+	using std::isnan;
+	using std::numeric_limits;
+	
+	//The outcome of one streaming request
+	struct StreamResult
+	{
+		u64 requestID{};
+		u32 modelIndex{};
+		ImportResult result{};
+		ModelBlock block{}; //empty unless result is RESULT_SUCCESS
+	};
+	
+	//Counters of a StreamQueue since it was opened
+	struct StreamStats
+	{
+		u64 queuedCount{};    //requests waiting for an I/O thread
+		u64 completedCount{}; //requests that finished with RESULT_SUCCESS
+		u64 failedCount{};    //requests that finished with any other result than RESULT_SUCCESS
+		u64 cancelledCount{}; //requests that were cancelled before they were read
+		
+		f64 averageQueueLatency{}; //average seconds from enqueue to the start of the read
+		f64 maxQueueLatency{};     //longest seconds from enqueue to the start of the read
+		
+		u64 bytesRead{};      //block bytes read by all I/O threads
+		f64 readSeconds{};    //combined seconds all I/O threads spent reading
+		f64 bytesPerSecond{}; //bytesRead / readSeconds
+	};
+	
+	//Loads model blocks of one kmd file on background threads. Requests with the lowest
+	//priority value are read first, so camera distance can be passed in as is.
+	//I/O threads read raw blocks and decode threads parse them, completions run on the
+	//thread that parsed the block and callbacks must not throw or close their own queue
+	class StreamQueue
+	{
+	public:
+		using Callback = function<void(StreamResult&&)>;
+		
+		StreamQueue() = default;
+		~StreamQueue() { Close(); }
+		
+		StreamQueue(const StreamQueue&) = delete;
+		StreamQueue& operator=(const StreamQueue&) = delete;
+		
+		//Opens the file and starts the threads, at least one I/O thread is always started,
+		//with decodeThreadCount 0 the I/O threads also parse the blocks they read.
+		//mode picks how the decoded blocks are verified
+		ImportResult Open(
+			const path& inFile,
+			u32 ioThreadCount = 1,
+			u32 decodeThreadCount = 1,
+			ValidationMode mode = ValidationMode::VALIDATION_DEFAULT)
+		{
+			Close();
+			
+			ImportResult openResult = file.Open(inFile, mode);
+			if (openResult != ImportResult::RESULT_SUCCESS) return openResult;
+			
+			filePath = inFile;
+			isStopping = false;
+			isDecodeStopping = false;
+			stats = {};
+			totalQueueLatency = 0.0;
+			
+			ioThreadCount = max(ioThreadCount, 1u);
+			isDecodedOnIo = decodeThreadCount == 0;
+			
+			for (u32 i = 0; i < ioThreadCount; i++) ioThreads.emplace_back([this] { IoLoop(); });
+			for (u32 i = 0; i < decodeThreadCount; i++) decodeThreads.emplace_back([this] { DecodeLoop(); });
+			
+			return ImportResult::RESULT_SUCCESS;
+		}
+		
+		//Cancels every request that has not been read yet,
+		//then waits for the requests that already started loading
+		void Close()
+		{
+			vector<Request> cancelled{};
+			
+			{
+				scoped_lock lock(queueMutex);
+				
+				isStopping = true;
+				
+				for (auto& [key, r] : pending) cancelled.push_back(move(r));
+				pending.clear();
+				pendingPriorities.clear();
+				
+				stats.cancelledCount += cancelled.size();
+				stats.queuedCount = 0;
+			}
+			ioCondition.notify_all();
+			
+			for (auto& r : cancelled) Finish(r, ImportResult::RESULT_CANCELLED, {});
+			
+			for (auto& t : ioThreads) t.join();
+			ioThreads.clear();
+			
+			//decode threads drain what the I/O threads already read before exiting
+			{
+				scoped_lock lock(queueMutex);
+				isDecodeStopping = true;
+			}
+			decodeCondition.notify_all();
+			
+			for (auto& t : decodeThreads) t.join();
+			decodeThreads.clear();
+			
+			file.Close();
+		}
+		
+		bool IsOpen() const { return file.IsOpen(); }
+		
+		//The tables of the streamed file, use FindModel to turn node names into model indexes
+		const vector<ModelTable>& GetTables() const { return file.GetTables(); }
+		
+		//Returns the model index of the first model with this node name or false if there is none
+		bool FindModel(
+			string_view name,
+			u32& outModelIndex) const
+		{
+			const ModelTable* t = file.FindModel(name);
+			if (!t) return false;
+			
+			outModelIndex = scast<u32>(t - file.GetTables().data());
+			
+			return true;
+		}
+		
+		//Queues the model for loading, onComplete runs once the block is loaded, failed or cancelled.
+		//Returns the request id or 0 if the index is out of range or the queue is closed
+		u64 Enqueue(
+			u32 modelIndex,
+			f32 priority,
+			Callback onComplete)
+		{
+			if (modelIndex >= file.GetTables().size()) return 0;
+			
+			priority = SanitizePriority(priority);
+			
+			u64 requestID{};
+			
+			{
+				scoped_lock lock(queueMutex);
+				
+				if (isStopping) return 0;
+				
+				requestID = nextRequestID++;
+				
+				pending.emplace(
+					PendingKey{ priority, requestID },
+					Request{ requestID, modelIndex, move(onComplete), steady_clock::now() });
+				pendingPriorities[requestID] = priority;
+				
+				stats.queuedCount++;
+			}
+			ioCondition.notify_one();
+			
+			return requestID;
+		}
+		
+		//Queues the model for loading and returns a future of its result,
+		//invalid indexes get a ready future with RESULT_INVALID_MODEL_COUNT
+		future<StreamResult> Enqueue(
+			u32 modelIndex,
+			f32 priority)
+		{
+			auto resultPromise = make_shared<promise<StreamResult>>();
+			future<StreamResult> resultFuture = resultPromise->get_future();
+			
+			u64 requestID = Enqueue(
+				modelIndex,
+				priority,
+				[resultPromise](StreamResult&& r) { resultPromise->set_value(move(r)); });
+			
+			if (requestID == 0)
+			{
+				StreamResult r{};
+				r.modelIndex = modelIndex;
+				r.result = ImportResult::RESULT_INVALID_MODEL_COUNT;
+				
+				resultPromise->set_value(move(r));
+			}
+			
+			return resultFuture;
+		}
+		
+		//Changes the priority of a request that has not been read yet,
+		//returns false if the request already started loading or does not exist
+		bool Reprioritize(
+			u64 requestID,
+			f32 priority)
+		{
+			priority = SanitizePriority(priority);
+			
+			scoped_lock lock(queueMutex);
+			
+			auto it = pendingPriorities.find(requestID);
+			if (it == pendingPriorities.end()) return false;
+			
+			auto node = pending.extract(PendingKey{ it->second, requestID });
+			node.key().first = priority;
+			pending.insert(move(node));
+			
+			it->second = priority;
+			
+			return true;
+		}
+		
+		//Cancels a request that has not been read yet, its completion runs with RESULT_CANCELLED
+		//before this returns. Returns false if the request already started loading or does not exist
+		bool Cancel(u64 requestID)
+		{
+			Request cancelled{};
+			
+			{
+				scoped_lock lock(queueMutex);
+				
+				auto it = pendingPriorities.find(requestID);
+				if (it == pendingPriorities.end()) return false;
+				
+				auto node = pending.extract(PendingKey{ it->second, requestID });
+				cancelled = move(node.mapped());
+				
+				pendingPriorities.erase(it);
+				
+				stats.queuedCount--;
+				stats.cancelledCount++;
+			}
+			
+			Finish(cancelled, ImportResult::RESULT_CANCELLED, {});
+			
+			return true;
+		}
+		
+		StreamStats GetStats() const
+		{
+			scoped_lock lock(queueMutex);
+			
+			StreamStats s = stats;
+			
+			u64 startedCount = s.completedCount + s.failedCount + readingCount;
+			if (startedCount > 0) s.averageQueueLatency = totalQueueLatency / scast<f64>(startedCount);
+			if (s.readSeconds > 0.0) s.bytesPerSecond = scast<f64>(s.bytesRead) / s.readSeconds;
+			
+			return s;
+		}
+	
+	private:
+		using PendingKey = pair<f32, u64>;
+		
+		struct Request
+		{
+			u64 requestID{};
+			u32 modelIndex{};
+			Callback onComplete{};
+			steady_clock::time_point enqueueTime{};
+		};
+		
+		struct ReadBlock
+		{
+			Request request{};
+			ImportResult result{};
+			vector<u8> blockData{};
+		};
+		
+		KmdFile file{};
+		path filePath{};
+		
+		mutable mutex queueMutex{};
+		condition_variable ioCondition{};
+		condition_variable decodeCondition{};
+		
+		//sorted by priority, then by request id so equal priorities load in enqueue order
+		map<PendingKey, Request> pending{};
+		unordered_map<u64, f32> pendingPriorities{};
+		
+		deque<ReadBlock> decodeQueue{};
+		
+		vector<thread> ioThreads{};
+		vector<thread> decodeThreads{};
+		
+		bool isStopping = true;
+		bool isDecodeStopping = true;
+		bool isDecodedOnIo{};
+		u64 nextRequestID = 1;
+		
+		StreamStats stats{};
+		f64 totalQueueLatency{};
+		u64 readingCount{};
+		
+		//NaN would break the ordering of the pending map
+		static f32 SanitizePriority(f32 priority)
+		{
+			return isnan(priority)
+				? numeric_limits<f32>::max()
+				: priority;
+		}
+		
+		void IoLoop()
+		{
+			//each I/O thread reads through its own handle so reads never wait on each other
+			KmdFile ioFile{};
+			ImportResult openResult = ioFile.Open(filePath);
+			
+			while (true)
+			{
+				Request r{};
+				
+				{
+					unique_lock lock(queueMutex);
+					ioCondition.wait(lock, [this] { return isStopping || !pending.empty(); });
+					
+					if (isStopping) return;
+					
+					auto node = pending.extract(pending.begin());
+					r = move(node.mapped());
+					pendingPriorities.erase(r.requestID);
+					
+					f64 latency = duration<f64>(steady_clock::now() - r.enqueueTime).count();
+					totalQueueLatency += latency;
+					if (latency > stats.maxQueueLatency) stats.maxQueueLatency = latency;
+					
+					stats.queuedCount--;
+					readingCount++;
+				}
+				
+				const ModelTable& t = file.GetTables()[r.modelIndex];
+				
+				ReadBlock b{};
+				b.result = openResult;
+				
+				auto readStart = steady_clock::now();
+				
+				if (b.result == ImportResult::RESULT_SUCCESS)
+				{
+					try
+					{
+						b.blockData.resize(t.blockSize);
+						
+						b.result = ioFile.ReadBytes(
+							t.blockOffset,
+							t.blockSize,
+							b.blockData.data());
+					}
+					catch (...)
+					{
+						b.result = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+					}
+				}
+				
+				f64 readTime = duration<f64>(steady_clock::now() - readStart).count();
+				
+				b.request = move(r);
+				
+				{
+					scoped_lock lock(queueMutex);
+					
+					if (b.result == ImportResult::RESULT_SUCCESS) stats.bytesRead += t.blockSize;
+					stats.readSeconds += readTime;
+					
+					if (!isDecodedOnIo) decodeQueue.push_back(move(b));
+				}
+				
+				if (isDecodedOnIo) Decode(b);
+				else decodeCondition.notify_one();
+			}
+		}
+		
+		void DecodeLoop()
+		{
+			while (true)
+			{
+				ReadBlock b{};
+				
+				{
+					unique_lock lock(queueMutex);
+					decodeCondition.wait(lock, [this] { return isDecodeStopping || !decodeQueue.empty(); });
+					
+					if (decodeQueue.empty()) return;
+					
+					b = move(decodeQueue.front());
+					decodeQueue.pop_front();
+				}
+				
+				Decode(b);
+			}
+		}
+		
+		void Decode(ReadBlock& b)
+		{
+			ModelBlock block{};
+			
+			if (b.result == ImportResult::RESULT_SUCCESS)
+			{
+				const ModelTable& t = file.GetTables()[b.request.modelIndex];
+				
+				try
+				{
+					b.result = ParseBlock(
+						b.blockData.data(),
+						b.blockData.size(),
+						block,
+						file.GetValidationMode(),
+						FindBlockChecksum(file.GetChecksums(), t.blockOffset));
+				}
+				catch (...)
+				{
+					b.result = ImportResult::RESULT_UNKNOWN_READ_ERROR;
+				}
+			}
+			
+			vector<u8>().swap(b.blockData);
+			
+			{
+				scoped_lock lock(queueMutex);
+				
+				if (b.result == ImportResult::RESULT_SUCCESS) stats.completedCount++;
+				else stats.failedCount++;
+				
+				readingCount--;
+			}
+			
+			Finish(b.request, b.result, move(block));
+		}
+		
+		static void Finish(
+			Request& r,
+			ImportResult result,
+			ModelBlock&& block)
+		{
+			if (!r.onComplete) return;
+			
+			StreamResult sr{};
+			sr.requestID = r.requestID;
+			sr.modelIndex = r.modelIndex;
+			sr.result = result;
+			sr.block = move(block);
+			
+			r.onComplete(move(sr));
+		}
+	};
+}
\ No newline at end of file
@@ -11,6 +11,9 @@
 //   - lock_m, lockwait_m (where applicable) and unlock_m for mutexes
 //   - jthread (joinable thread) which returns the created thread so it can be joined
 //   - dthread (self-exiting thread)
+//   - ThreadPool (work-stealing pool with per-worker deques and optional thread pinning)
+//   - TaskGroup (waitable group of pool tasks)
+//   - parallel_for (index range split into grain sized pool tasks)
 //------------------------------------------------------------------------------
 
 #pragma once
@@ -19,6 +22,23 @@
 #include <concepts>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+#endif
 
 namespace KalaHeaders::KalaThread
 {	
@@ -39,6 +59,21 @@ namespace KalaHeaders::KalaThread
 	using std::chrono::duration;
 	using std::chrono::time_point;
 	using std::remove_cvref_t;
+	using std::mutex;
+	using std::scoped_lock;
+	using std::unique_lock;
+	using std::condition_variable;
+	using std::deque;
+	using std::vector;
+	using std::unique_ptr;
+	using std::make_unique;
+	using std::shared_ptr;
+	using std::make_shared;
+	using std::function;
+	using std::min;
+	using std::max;
+	using std::invoke;
+	using std::move;
 	
 	//
 	// CREATE THREAD
@@ -309,4 +344,347 @@ namespace KalaHeaders::KalaThread
 		ptr.store(value, memory_order_release);
 		return true;
 	}
+	
+	//
+	// THREAD POOL
+	//
+	
+	//Pool of worker threads where each worker owns a deque of tasks, workers run
+	//their own newest task first and steal the oldest task of another worker when empty.
+	//Tasks must not throw, an escaping exception terminates the process like in a raw thread
+	class ThreadPool
+	{
+	public:
+		//Starts threadCount workers, 0 uses one per hardware thread.
+		//pinThreads locks worker n to logical core n, wrapping around the core count
+		explicit ThreadPool(
+			size_t threadCount = 0,
+			bool pinThreads = false)
+		{
+			if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+			
+			queues.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; i++) queues.push_back(make_unique<WorkerQueue>());
+			
+			threads.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; i++)
+			{
+				threads.push_back(jthread([this, i] { worker_loop(i); }));
+				
+				if (pinThreads) pin_thread(threads.back(), i);
+			}
+		}
+		
+		//Finishes every queued task, then joins all workers
+		~ThreadPool()
+		{
+			{
+				scoped_lock lock(sleepMutex);
+				stopping = true;
+			}
+			sleepCondition.notify_all();
+			
+			for (auto& t : threads) t.join();
+		}
+		
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		
+		size_t size() const { return threads.size(); }
+		
+		//Queues a task, tasks submitted from a worker of this pool
+		//go to that worker's own deque to keep related work on the same core
+		template <invocable F>
+		void submit(F&& func)
+		{
+			size_t index = currentPool == this
+				? currentIndex
+				: nextQueue.fetch_add(1, memory_order_relaxed) % queues.size();
+				
+			{
+				scoped_lock lock(queues[index]->m);
+				queues[index]->tasks.emplace_back(forward<F>(func));
+			}
+			
+			{
+				scoped_lock lock(sleepMutex);
+				queuedCount++;
+			}
+			sleepCondition.notify_one();
+		}
+		
+		//Runs one queued task on the calling thread,
+		//returns false if every deque was empty
+		bool try_run_one()
+		{
+			size_t start = currentPool == this
+				? currentIndex
+				: nextQueue.load(memory_order_relaxed) % queues.size();
+				
+			function<void()> task{};
+			
+			if (!pop_task(start, task)) return false;
+			
+			task();
+			return true;
+		}
+		
+	private:
+		struct WorkerQueue
+		{
+			mutex m{};
+			deque<function<void()>> tasks{};
+		};
+		
+		vector<unique_ptr<WorkerQueue>> queues{};
+		vector<thread> threads{};
+		
+		mutex sleepMutex{};
+		condition_variable sleepCondition{};
+		size_t queuedCount{};
+		bool stopping{};
+		
+		atomic<size_t> nextQueue{};
+		
+		static inline thread_local ThreadPool* currentPool{};
+		static inline thread_local size_t currentIndex{};
+		
+		//Takes the newest task of deque 'index' or steals the oldest task of another deque
+		bool pop_task(
+			size_t index,
+			function<void()>& outTask)
+		{
+			{
+				scoped_lock lock(queues[index]->m);
+				auto& own = queues[index]->tasks;
+				
+				if (!own.empty())
+				{
+					outTask = move(own.back());
+					own.pop_back();
+				}
+			}
+			
+			for (size_t i = 1; !outTask && i < queues.size(); i++)
+			{
+				WorkerQueue& victim = *queues[(index + i) % queues.size()];
+				
+				scoped_lock lock(victim.m);
+				
+				if (!victim.tasks.empty())
+				{
+					outTask = move(victim.tasks.front());
+					victim.tasks.pop_front();
+				}
+			}
+			
+			if (!outTask) return false;
+			
+			scoped_lock lock(sleepMutex);
+			queuedCount--;
+			
+			return true;
+		}
+		
+		void worker_loop(size_t index)
+		{
+			currentPool = this;
+			currentIndex = index;
+			
+			while (true)
+			{
+				function<void()> task{};
+				
+				if (pop_task(index, task))
+				{
+					task();
+					continue;
+				}
+				
+				unique_lock lock(sleepMutex);
+				sleepCondition.wait(lock, [this] { return stopping || queuedCount > 0; });
+				
+				if (stopping
+					&& queuedCount == 0)
+				{
+					return;
+				}
+			}
+		}
+		
+		static void pin_thread(
+			thread& t,
+			size_t index)
+		{
+			size_t core = index % max(thread::hardware_concurrency(), 1u);
+			
+#ifdef _WIN32
+			SetThreadAffinityMask(
+				t.native_handle(),
+				DWORD_PTR(1) << (core % (sizeof(DWORD_PTR) * 8)));
+#else
+			cpu_set_t set{};
+			CPU_ZERO(&set);
+			CPU_SET(core, &set);
+			
+			pthread_setaffinity_np(
+				t.native_handle(),
+				sizeof(set),
+				&set);
+#endif
+		}
+	};
+	
+	//Group of pool tasks that can be waited on together. Tasks are kept in the group's own
+	//deque and the pool only gets a ticket per task that runs the oldest task still there,
+	//so wait can run this group's tasks inline without ever running unrelated pool work
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(ThreadPool& newPool)
+			: pool(newPool),
+			state(make_shared<State>()) {}
+		
+		//Waits for the remaining tasks so none outlive the group
+		~TaskGroup() { wait(); }
+		
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+		
+		template <invocable F>
+		void run(F&& func)
+		{
+			//counted before it is queued so a ticket can never finish it first
+			state->pending.fetch_add(1, memory_order_relaxed);
+			
+			try
+			{
+				scoped_lock lock(state->m);
+				state->tasks.emplace_back(forward<F>(func));
+			}
+			catch (...)
+			{
+				state->pending.fetch_sub(1, memory_order_release);
+				throw;
+			}
+			
+			//a ticket that wait already emptied the deque for returns right away,
+			//it holds the state so it never points to a destroyed group
+			try
+			{
+				pool.submit([groupState = state]() { run_one(*groupState); });
+			}
+			catch (...)
+			{
+				//the task stays queued in the group and wait runs it inline
+			}
+		}
+		
+		//Runs this group's queued tasks on the calling thread, then sleeps until
+		//the ones already running on pool workers have finished
+		void wait()
+		{
+			while (true)
+			{
+				if (run_one(*state, true)) continue;
+				
+				size_t pending = state->pending.load(memory_order_acquire);
+				if (pending == 0) return;
+				
+				state->pending.wait(pending, memory_order_acquire);
+			}
+		}
+		
+	private:
+		struct State
+		{
+			mutex m{};
+			deque<function<void()>> tasks{};
+			atomic<size_t> pending{};
+		};
+		
+		ThreadPool& pool;
+		shared_ptr<State> state{};
+		
+		//Runs one queued task of the group, the newest one for the waiting thread
+		//because its data is most likely still in cache, returns false if none was queued
+		static bool run_one(
+			State& groupState,
+			bool isNewest = false)
+		{
+			function<void()> task{};
+			
+			{
+				scoped_lock lock(groupState.m);
+				if (groupState.tasks.empty()) return false;
+				
+				if (isNewest)
+				{
+					task = move(groupState.tasks.back());
+					groupState.tasks.pop_back();
+				}
+				else
+				{
+					task = move(groupState.tasks.front());
+					groupState.tasks.pop_front();
+				}
+			}
+			
+			//a throwing task still counts as finished so wait can't block on it forever
+			try { task(); }
+			catch (...)
+			{
+				finish_one(groupState);
+				throw;
+			}
+			
+			finish_one(groupState);
+			
+			return true;
+		}
+		
+		static void finish_one(State& groupState)
+		{
+			if (groupState.pending.fetch_sub(1, memory_order_release) == 1) groupState.pending.notify_all();
+		}
+	};
+	
+	//Calls func(i) for every i in [begin, end) on the pool and returns once all calls finished.
+	//Each task handles grainSize indices, 0 picks four tasks per worker
+	template <typename F>
+		requires invocable<F&, size_t>
+	void parallel_for(
+		ThreadPool& pool,
+		size_t begin,
+		size_t end,
+		size_t grainSize,
+		F&& func)
+	{
+		if (begin >= end) return;
+		
+		size_t count = end - begin;
+		
+		if (grainSize == 0) grainSize = max(count / (pool.size() * 4), size_t(1));
+		
+		//too small to be worth a task
+		if (count <= grainSize)
+		{
+			for (size_t i = begin; i < end; i++) invoke(func, i);
+			return;
+		}
+		
+		TaskGroup group(pool);
+		
+		for (size_t chunk = begin; chunk < end; chunk += grainSize)
+		{
+			size_t chunkEnd = min(chunk + grainSize, end);
+			
+			group.run([&func, chunk, chunkEnd]()
+				{
+					for (size_t i = chunk; i < chunkEnd; i++) invoke(func, i);
+				});
+		}
+		
+		group.wait();
+	}
 }
\ No newline at end of file
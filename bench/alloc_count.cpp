@@ -0,0 +1,31 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+
+using std::atomic;
+using std::memory_order_relaxed;
+
+using u64 = uint64_t;
+
+//Replaces the global operator new and delete of KalaModelBench to count heap allocations.
+//They live in their own translation unit so the compiler can't inline them into their callers
+static atomic<u64> allocationCount{};
+
+u64 GetAllocationCount() { return allocationCount.load(memory_order_relaxed); }
+
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, memory_order_relaxed);
+	
+	if (void* p = malloc(size == 0 ? 1 : size)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
\ No newline at end of file
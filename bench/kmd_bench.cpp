@@ -0,0 +1,837 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <memory_resource>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+#include "KalaHeaders/import_kmd.hpp"
+#include "KalaHeaders/batch_kmd.hpp"
+
+#include "export.hpp"
+
+using KalaModel::Export;
+using KalaModel::ExportStream;
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::ThreadPool;
+using KalaHeaders::KalaThread::TaskGroup;
+using KalaHeaders::KalaThread::parallel_for;
+using KalaHeaders::KalaModelData::ModelBlock;
+using KalaHeaders::KalaModelData::ModelHeader;
+using KalaHeaders::KalaModelData::ModelTable;
+using KalaHeaders::KalaModelData::Vertex;
+using KalaHeaders::KalaModelData::ImportResult;
+using KalaHeaders::KalaModelData::ResultToString;
+using KalaHeaders::KalaModelData::KmdFile;
+using KalaHeaders::KalaModelData::KmdReader;
+using KalaHeaders::KalaModelData::ImportKMD;
+using KalaHeaders::KalaModelData::PmrModelBlock;
+using KalaHeaders::KalaModelData::GetHeaderData;
+using KalaHeaders::KalaModelData::KMD_VERSION_2;
+using KalaHeaders::KalaModelData::VERTICE_DATA_OFFSET;
+using KalaHeaders::KalaModelData::GetTableData;
+using KalaHeaders::KalaModelData::StreamModels;
+using KalaHeaders::KalaModelData::BatchLoader;
+using KalaHeaders::KalaModelData::BlockRequest;
+
+using std::string;
+using std::string_view;
+using std::vector;
+using std::ofstream;
+using std::ifstream;
+using std::ios;
+using std::thread;
+using std::atomic;
+using std::to_string;
+using std::move;
+using std::function;
+using std::min;
+using std::max;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::filesystem::path;
+using std::filesystem::temp_directory_path;
+using std::filesystem::create_directories;
+using std::filesystem::remove_all;
+using std::filesystem::status;
+using std::filesystem::file_size;
+using std::pmr::monotonic_buffer_resource;
+using std::pmr::null_memory_resource;
+using std::error_code;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f32 = float;
+using f64 = double;
+
+//Global heap allocations made by the process so far, counted by the operator new of alloc_count.cpp
+u64 GetAllocationCount();
+
+struct BenchOptions
+{
+	bool isQuick{}; //small sizes so ctest finishes in seconds
+	bool isLarge{}; //runs the version 2 round trip with a file larger than 4 GB
+	path workDir{}; //scratch folder for the generated kmd files
+};
+
+struct Bench
+{
+	string_view name{};
+	bool (*run)(const BenchOptions&){};
+};
+
+//Runs func repeatCount times and returns the fastest run in seconds
+static f64 TimeBest(
+	u32 repeatCount,
+	const function<void()>& func)
+{
+	f64 best{};
+	
+	for (u32 i = 0; i < repeatCount; i++)
+	{
+		auto start = steady_clock::now();
+		func();
+		f64 seconds = duration<f64>(steady_clock::now() - start).count();
+		
+		if (i == 0 || seconds < best) best = seconds;
+	}
+	
+	return max(best, 1e-9);
+}
+
+static string FormatRate(
+	f64 count,
+	f64 seconds,
+	string_view unit)
+{
+	return to_string(scast<u64>(count / seconds)) + " " + string(unit) + "/s ("
+		+ to_string(seconds * 1000.0) + " ms)";
+}
+
+static void PrintResult(
+	string_view name,
+	const string& result)
+{
+	Log::Print("  " + string(name) + ": " + result);
+}
+
+static bool PrintFailure(
+	string_view name,
+	ImportResult result)
+{
+	Log::Print(string(name) + " returned " + ResultToString(result) + "!", "BENCH", LogType::LOG_ERROR);
+	return false;
+}
+
+//Model with vertexCount vertices and indexCount indices whose values are derived from seed,
+//so a loaded block can be checked against a freshly made one
+static ModelBlock MakeBlock(
+	u32 seed,
+	u32 vertexCount,
+	u32 indexCount)
+{
+	ModelBlock b{};
+	
+	string name = "model_" + to_string(seed);
+	name.copy(b.nodeName, sizeof(b.nodeName) - 1);
+	
+	b.rotation[0] = 1.0f;
+	b.size[0] = b.size[1] = b.size[2] = 1.0f;
+	
+	b.vertices.resize(vertexCount);
+	for (u32 i = 0; i < vertexCount; i++)
+	{
+		Vertex& v = b.vertices[i];
+		v.position[0] = scast<f32>(seed % 1024);
+		v.position[1] = scast<f32>(i % 1024);
+		v.normal[2] = 1.0f;
+		v.texCoord[0] = scast<f32>(i % 64) / 64.0f;
+		v.tangent[0] = 1.0f;
+		v.tangent[3] = 1.0f;
+	}
+	
+	b.indices.resize(indexCount);
+	for (u32 i = 0; i < indexCount; i++) b.indices[i] = (seed + i) % max(vertexCount, 1u);
+	
+	b.verticesSize = vertexCount * sizeof(Vertex);
+	b.indicesSize = indexCount * sizeof(u32);
+	
+	return b;
+}
+
+//True if the geometry of a loaded block matches the block it was exported from
+template <typename Block>
+static bool IsSameBlock(
+	const Block& loaded,
+	const ModelBlock& expected)
+{
+	return loaded.vertices.size() == expected.vertices.size()
+		&& loaded.indices.size() == expected.indices.size()
+		&& memcmp(loaded.vertices.data(), expected.vertices.data(), expected.verticesSize) == 0
+		&& memcmp(loaded.indices.data(), expected.indices.data(), expected.indicesSize) == 0;
+}
+
+template <typename Block>
+static bool IsSameBlocks(
+	const vector<Block>& loaded,
+	const vector<ModelBlock>& expected)
+{
+	if (loaded.size() != expected.size()) return false;
+	
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		if (!IsSameBlock(loaded[i], expected[i])) return false;
+	}
+	
+	return true;
+}
+
+static bool WriteBytes(
+	const path& target,
+	const vector<u8>& bytes)
+{
+	ofstream out(target, ios::binary | ios::trunc);
+	out.write(rcast<const char*>(bytes.data()), scast<std::streamsize>(bytes.size()));
+	
+	return out.good();
+}
+
+//
+// POOL
+//
+
+//Small tasks like the per-block work of the loaders, on the shared pool and with one thread per task
+static bool Bench_Pool(const BenchOptions& options)
+{
+	u32 taskCount = options.isQuick ? 2000 : 20000;
+	u32 workerCount = max(thread::hardware_concurrency(), 1u);
+	
+	atomic<u64> sink{};
+	auto work = [&sink](u64 seed)
+	{
+		u64 value = seed;
+		for (u32 i = 0; i < 2000; i++) value = value * 6364136223846793005ull + 1442695040888963407ull;
+		
+		sink.fetch_add(value, std::memory_order_relaxed);
+	};
+	
+	//at most one thread per hardware thread is alive at once, as a naive loader would do
+	f64 threadSeconds = TimeBest(3, [&]()
+	{
+		vector<thread> threads{};
+		threads.reserve(workerCount);
+		
+		for (u32 i = 0; i < taskCount; i++)
+		{
+			threads.emplace_back(work, i);
+			
+			if (threads.size() < workerCount) continue;
+			
+			for (auto& t : threads) t.join();
+			threads.clear();
+		}
+		
+		for (auto& t : threads) t.join();
+	});
+	
+	ThreadPool pool(workerCount);
+	
+	f64 groupSeconds = TimeBest(3, [&]()
+	{
+		TaskGroup group(pool);
+		for (u32 i = 0; i < taskCount; i++) group.run([&work, i]() { work(i); });
+		
+		group.wait();
+	});
+	
+	f64 forSeconds = TimeBest(3, [&]()
+	{
+		parallel_for(
+			pool,
+			0,
+			taskCount,
+			0,
+			[&work](size_t i) { work(i); });
+	});
+	
+	PrintResult("thread per task", FormatRate(taskCount, threadSeconds, "tasks"));
+	PrintResult("pool task group", FormatRate(taskCount, groupSeconds, "tasks"));
+	PrintResult("pool parallel_for", FormatRate(taskCount, forSeconds, "tasks"));
+	
+	return true;
+}
+
+//
+// OPEN
+//
+
+//Per-file cost of opening many small kmd files, as a level with thousands of props does
+static bool Bench_Open(const BenchOptions& options)
+{
+	u32 fileCount = options.isQuick ? 200 : 10000;
+	
+	vector<ModelBlock> blocks{};
+	for (u32 i = 0; i < 4; i++) blocks.push_back(MakeBlock(i, 24, 36));
+	
+	vector<u8> bytes{};
+	if (!Export::BuildKMF(1, blocks, bytes)) return false;
+	
+	vector<path> files{};
+	for (u32 i = 0; i < fileCount; i++)
+	{
+		files.push_back(options.workDir / ("open_" + to_string(i) + ".kmd"));
+		if (!WriteBytes(files.back(), bytes)) return false;
+	}
+	
+	//what the import path did before KmdFile, a status check and four opens that each read the header
+	f64 legacySeconds = TimeBest(3, [&]()
+	{
+		char header[32]{};
+		
+		for (const auto& f : files)
+		{
+			(void)status(f);
+			
+			for (u32 i = 0; i < 4; i++)
+			{
+				ifstream in(f, ios::binary);
+				in.read(header, sizeof(header));
+			}
+		}
+	});
+	
+	ImportResult result{};
+	
+	f64 openSeconds = TimeBest(3, [&]()
+	{
+		for (const auto& f : files)
+		{
+			KmdFile file{};
+			
+			ImportResult openResult = file.Open(f);
+			if (openResult != ImportResult::RESULT_SUCCESS) result = openResult;
+		}
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("KmdFile::Open", result);
+	
+	ModelHeader header{};
+	vector<ModelTable> tables{};
+	vector<ModelBlock> loaded{};
+	
+	f64 importSeconds = TimeBest(3, [&]()
+	{
+		for (const auto& f : files)
+		{
+			ImportResult importResult = ImportKMD(f, header, tables, loaded, 1);
+			if (importResult != ImportResult::RESULT_SUCCESS) result = importResult;
+		}
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("ImportKMD", result);
+	if (!IsSameBlocks(loaded, blocks)) return false;
+	
+	PrintResult("status and four header opens", FormatRate(fileCount, legacySeconds, "files"));
+	PrintResult("KmdFile::Open", FormatRate(fileCount, openSeconds, "files"));
+	PrintResult("ImportKMD", FormatRate(fileCount, importSeconds, "files"));
+	
+	return true;
+}
+
+//
+// STREAM
+//
+
+//Exports blockCount blocks of vertexCount vertices to one file and returns their tables
+static bool WriteModelFile(
+	const path& target,
+	u32 blockCount,
+	u32 vertexCount,
+	vector<ModelBlock>& outBlocks,
+	vector<ModelTable>& outTables)
+{
+	outBlocks.clear();
+	for (u32 i = 0; i < blockCount; i++) outBlocks.push_back(MakeBlock(i, vertexCount, vertexCount * 3 / 2));
+	
+	vector<u8> bytes{};
+	if (!Export::BuildKMF(1, outBlocks, bytes)
+		|| !WriteBytes(target, bytes))
+	{
+		return false;
+	}
+	
+	ImportResult tableResult = GetTableData(target, outTables);
+	if (tableResult != ImportResult::RESULT_SUCCESS) return PrintFailure("GetTableData", tableResult);
+	
+	return true;
+}
+
+//How StreamModels read a block before it was read with one read, a seek and one read per field
+static bool ReadBlockByFields(
+	ifstream& in,
+	const ModelTable& table,
+	ModelBlock& outBlock)
+{
+	ModelBlock b{};
+	
+	in.seekg(scast<std::streamoff>(table.blockOffset));
+	
+	in.read(b.nodeName, sizeof(b.nodeName));
+	in.read(b.meshName, sizeof(b.meshName));
+	in.read(b.nodePath, sizeof(b.nodePath));
+	in.read(rcast<char*>(&b.dataTypeFlags), 1);
+	in.read(rcast<char*>(&b.renderType), 1);
+	
+	for (auto& f : b.position) in.read(rcast<char*>(&f), sizeof(f));
+	for (auto& f : b.rotation) in.read(rcast<char*>(&f), sizeof(f));
+	for (auto& f : b.size) in.read(rcast<char*>(&f), sizeof(f));
+	
+	in.read(rcast<char*>(&b.verticesOffset), sizeof(u32));
+	in.read(rcast<char*>(&b.verticesSize), sizeof(u32));
+	in.read(rcast<char*>(&b.indicesOffset), sizeof(u32));
+	in.read(rcast<char*>(&b.indicesSize), sizeof(u32));
+	
+	b.vertices.resize(b.verticesSize / sizeof(Vertex));
+	in.read(rcast<char*>(b.vertices.data()), b.verticesSize);
+	
+	b.indices.resize(b.indicesSize / sizeof(u32));
+	in.read(rcast<char*>(b.indices.data()), b.indicesSize);
+	
+	outBlock = move(b);
+	
+	return !in.fail();
+}
+
+//Streams 1024 small blocks of one file, field by field as before and with one read per block
+static bool Bench_Stream(const BenchOptions& options)
+{
+	u32 blockCount = 1024;
+	u32 repeatCount = options.isQuick ? 1 : 10;
+	
+	path file = options.workDir / "stream.kmd";
+	
+	vector<ModelBlock> blocks{};
+	vector<ModelTable> tables{};
+	if (!WriteModelFile(file, blockCount, 64, blocks, tables)) return false;
+	
+	vector<ModelBlock> loaded(tables.size());
+	bool isRead = true;
+	
+	f64 fieldSeconds = TimeBest(repeatCount, [&]()
+	{
+		ifstream in(file, ios::binary);
+		
+		for (size_t i = 0; i < tables.size(); i++)
+		{
+			if (!ReadBlockByFields(in, tables[i], loaded[i])) isRead = false;
+		}
+	});
+	
+	if (!isRead
+		|| !IsSameBlocks(loaded, blocks))
+	{
+		return false;
+	}
+	
+	ImportResult result{};
+	
+	f64 streamSeconds = TimeBest(repeatCount, [&]()
+	{
+		ImportResult streamResult = StreamModels(file, tables, loaded);
+		if (streamResult != ImportResult::RESULT_SUCCESS) result = streamResult;
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("StreamModels", result);
+	if (!IsSameBlocks(loaded, blocks)) return false;
+	
+	PrintResult("seek and read per field", FormatRate(blockCount, fieldSeconds, "blocks"));
+	PrintResult("StreamModels", FormatRate(blockCount, streamSeconds, "blocks"));
+	
+	return true;
+}
+
+//
+// BATCH
+//
+
+//Loads every block of several files with StreamModels per file and with one BatchLoader request set,
+//through io_uring where the kernel allows it and through the positional read threads
+static bool Bench_Batch(const BenchOptions& options)
+{
+	u32 fileCount = options.isQuick ? 4 : 24;
+	u32 blockCount = options.isQuick ? 64 : 256;
+	u32 repeatCount = options.isQuick ? 1 : 5;
+	
+	vector<path> files{};
+	vector<vector<ModelBlock>> blocks(fileCount);
+	vector<vector<ModelTable>> tables(fileCount);
+	
+	for (u32 i = 0; i < fileCount; i++)
+	{
+		files.push_back(options.workDir / ("batch_" + to_string(i) + ".kmd"));
+		if (!WriteModelFile(files[i], blockCount, 256, blocks[i], tables[i])) return false;
+	}
+	
+	u32 totalBlocks = fileCount * blockCount;
+	vector<vector<ModelBlock>> streamed(fileCount);
+	ImportResult result{};
+	
+	f64 streamSeconds = TimeBest(repeatCount, [&]()
+	{
+		for (u32 i = 0; i < fileCount; i++)
+		{
+			ImportResult streamResult = StreamModels(files[i], tables[i], streamed[i]);
+			if (streamResult != ImportResult::RESULT_SUCCESS) result = streamResult;
+		}
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("StreamModels", result);
+	
+	for (u32 i = 0; i < fileCount; i++)
+	{
+		if (!IsSameBlocks(streamed[i], blocks[i])) return false;
+	}
+	
+	PrintResult("StreamModels", FormatRate(totalBlocks, streamSeconds, "blocks"));
+	
+	//queue depth 0 always uses the read threads
+	for (u32 queueDepth : { 0u, 32u })
+	{
+		BatchLoader loader{};
+		loader.Open(queueDepth);
+		
+		vector<BlockRequest> requests{};
+		for (u32 i = 0; i < fileCount; i++)
+		{
+			u32 fileIndex{};
+			
+			ImportResult addResult = loader.AddFile(files[i], fileIndex);
+			if (addResult != ImportResult::RESULT_SUCCESS) return PrintFailure("BatchLoader::AddFile", addResult);
+			
+			for (u32 m = 0; m < blockCount; m++) requests.push_back({ fileIndex, m });
+		}
+		
+		vector<ModelBlock> loaded{};
+		
+		f64 batchSeconds = TimeBest(repeatCount, [&]()
+		{
+			ImportResult loadResult = loader.LoadBlocks(requests, loaded);
+			if (loadResult != ImportResult::RESULT_SUCCESS) result = loadResult;
+		});
+		
+		if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("BatchLoader::LoadBlocks", result);
+		
+		for (size_t r = 0; r < requests.size(); r++)
+		{
+			if (!IsSameBlock(loaded[r], blocks[requests[r].fileIndex][requests[r].modelIndex])) return false;
+		}
+		
+		string name = loader.IsUsingIoUring()
+			? "BatchLoader io_uring, depth " + to_string(queueDepth)
+			: "BatchLoader read threads";
+		
+		PrintResult(name, FormatRate(totalBlocks, batchSeconds, "blocks"));
+	}
+	
+	return true;
+}
+
+//
+// READER
+//
+
+//Many threads reading blocks of one file through one shared KmdReader,
+//against each thread streaming its share with StreamModels
+static bool Bench_Reader(const BenchOptions& options)
+{
+	u32 blockCount = options.isQuick ? 256 : 4096;
+	u32 repeatCount = options.isQuick ? 1 : 5;
+	
+	path file = options.workDir / "reader.kmd";
+	
+	vector<ModelBlock> blocks{};
+	vector<ModelTable> tables{};
+	if (!WriteModelFile(file, blockCount, 256, blocks, tables)) return false;
+	
+	KmdReader reader{};
+	
+	ImportResult openResult = reader.Open(file);
+	if (openResult != ImportResult::RESULT_SUCCESS) return PrintFailure("KmdReader::Open", openResult);
+	
+	vector<u32> threadCounts = options.isQuick
+		? vector<u32>{ 1, 4 }
+		: vector<u32>{ 1, 2, 4, 8, 16, 32 };
+	
+	for (u32 threadCount : threadCounts)
+	{
+		vector<ModelBlock> loaded(blockCount);
+		atomic<u32> failedCount{};
+		
+		//thread t reads every threadCount-th block starting from t
+		auto runThreads = [&](const function<void(u32)>& work)
+		{
+			vector<thread> threads{};
+			for (u32 t = 1; t < threadCount; t++) threads.emplace_back(work, t);
+			
+			work(0);
+			
+			for (auto& t : threads) t.join();
+		};
+		
+		f64 readerSeconds = TimeBest(repeatCount, [&]()
+		{
+			runThreads([&](u32 t)
+			{
+				for (u32 i = t; i < blockCount; i += threadCount)
+				{
+					if (reader.ReadBlock(tables[i], loaded[i]) != ImportResult::RESULT_SUCCESS) failedCount++;
+				}
+			});
+		});
+		
+		if (failedCount > 0
+			|| !IsSameBlocks(loaded, blocks))
+		{
+			return false;
+		}
+		
+		f64 streamSeconds = TimeBest(repeatCount, [&]()
+		{
+			runThreads([&](u32 t)
+			{
+				vector<ModelTable> share{};
+				for (u32 i = t; i < blockCount; i += threadCount) share.push_back(tables[i]);
+				
+				vector<ModelBlock> shareBlocks{};
+				if (StreamModels(file, share, shareBlocks) != ImportResult::RESULT_SUCCESS) failedCount++;
+			});
+		});
+		
+		if (failedCount > 0) return false;
+		
+		string threads = to_string(threadCount) + (threadCount == 1 ? " thread" : " threads");
+		
+		PrintResult("KmdReader, " + threads, FormatRate(blockCount, readerSeconds, "blocks"));
+		PrintResult("StreamModels per thread, " + threads, FormatRate(blockCount, streamSeconds, "blocks"));
+	}
+	
+	return true;
+}
+
+//
+// ALLOCATIONS
+//
+
+//Heap allocations and time of one ImportKMD into vectors and into a caller-provided arena
+//of modelBlocksSize bytes, which has no upstream so the import fails if the geometry overflows it
+static bool Bench_Allocations(const BenchOptions& options)
+{
+	u32 blockCount = options.isQuick ? 256 : 1024;
+	u32 repeatCount = options.isQuick ? 1 : 10;
+	
+	path file = options.workDir / "allocations.kmd";
+	
+	vector<ModelBlock> blocks{};
+	vector<ModelTable> tables{};
+	if (!WriteModelFile(file, blockCount, 64, blocks, tables)) return false;
+	
+	ModelHeader header{};
+	
+	ImportResult result = GetHeaderData(file, header);
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("GetHeaderData", result);
+	
+	vector<ModelBlock> loaded{};
+	u64 vectorAllocations{};
+	
+	f64 vectorSeconds = TimeBest(repeatCount, [&]()
+	{
+		vector<ModelBlock> out{};
+		
+		u64 before = GetAllocationCount();
+		ImportResult importResult = ImportKMD(file, header, tables, out, 1);
+		vectorAllocations = GetAllocationCount() - before;
+		
+		if (importResult != ImportResult::RESULT_SUCCESS) result = importResult;
+		loaded = move(out);
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("ImportKMD", result);
+	if (!IsSameBlocks(loaded, blocks)) return false;
+	
+	vector<u8> arena(scast<size_t>(header.modelBlocksSize));
+	bool isSame{};
+	u64 arenaAllocations{};
+	
+	f64 arenaSeconds = TimeBest(repeatCount, [&]()
+	{
+		monotonic_buffer_resource resource(arena.data(), arena.size(), null_memory_resource());
+		vector<PmrModelBlock> out{};
+		
+		u64 before = GetAllocationCount();
+		ImportResult importResult = ImportKMD(file, header, tables, out, &resource);
+		arenaAllocations = GetAllocationCount() - before;
+		
+		if (importResult != ImportResult::RESULT_SUCCESS) result = importResult;
+		
+		//the blocks point into the arena, so they are checked before the resource goes away
+		isSame = IsSameBlocks(out, blocks);
+	});
+	
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("ImportKMD into an arena", result);
+	if (!isSame) return false;
+	
+	PrintResult("ImportKMD", to_string(vectorAllocations) + " allocations, " + FormatRate(blockCount, vectorSeconds, "blocks"));
+	PrintResult("ImportKMD into an arena", to_string(arenaAllocations) + " allocations, " + FormatRate(blockCount, arenaSeconds, "blocks"));
+	
+	return true;
+}
+
+//
+// VERSION 2
+//
+
+//Streams blockCount generated blocks to a file past the version 1 limits and reads every block back
+//through a KmdReader, one block at a time so even the large run only keeps one block in memory.
+//The large run writes 100k blocks and over 4 GB, so block offsets need all 64 bits
+static bool Bench_Version2(const BenchOptions& options)
+{
+	u32 blockCount = options.isLarge ? 100000 : 5000;
+	u32 vertexCount = options.isLarge ? 900 : 64;
+	u32 indexCount = vertexCount * 3 / 2;
+	
+	u64 blockSize = VERTICE_DATA_OFFSET + vertexCount * sizeof(Vertex) + indexCount * sizeof(u32);
+	path file = options.workDir / "version2.kmd";
+	
+	auto exportStart = steady_clock::now();
+	
+	{
+		ExportStream stream{};
+		if (!stream.Open(file, 1, blockCount, blockSize * blockCount)) return false;
+		
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			if (!stream.WriteBlock(MakeBlock(i, vertexCount, indexCount))) return false;
+		}
+		
+		if (!stream.Finish()) return false;
+	}
+	
+	f64 exportSeconds = duration<f64>(steady_clock::now() - exportStart).count();
+	
+	error_code ec{};
+	u64 fileSize = file_size(file, ec);
+	if (ec) return false;
+	
+	auto readStart = steady_clock::now();
+	
+	KmdReader reader{};
+	
+	ImportResult result = reader.Open(file);
+	if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("KmdReader::Open", result);
+	
+	if (reader.GetHeader().version != KMD_VERSION_2
+		|| reader.GetTables().size() != blockCount)
+	{
+		return false;
+	}
+	
+	ModelBlock loaded{};
+	
+	for (u32 i = 0; i < blockCount; i++)
+	{
+		result = reader.ReadBlock(reader.GetTables()[i], loaded);
+		if (result != ImportResult::RESULT_SUCCESS) return PrintFailure("KmdReader::ReadBlock", result);
+		
+		if (!IsSameBlock(loaded, MakeBlock(i, vertexCount, indexCount))) return false;
+	}
+	
+	f64 readSeconds = max(duration<f64>(steady_clock::now() - readStart).count(), 1e-9);
+	
+	u64 lastOffset = reader.GetTables().back().blockOffset;
+	
+	PrintResult("file", to_string(fileSize / 1048576) + " MB, " + to_string(blockCount) + " blocks, last block at byte " + to_string(lastOffset));
+	PrintResult("ExportStream", FormatRate(blockCount, max(exportSeconds, 1e-9), "blocks"));
+	PrintResult("KmdReader", FormatRate(blockCount, readSeconds, "blocks"));
+	
+	remove_all(file, ec);
+	
+	return true;
+}
+
+static const Bench BENCHES[] =
+{
+	{ "pool", Bench_Pool },
+	{ "open", Bench_Open },
+	{ "stream", Bench_Stream },
+	{ "batch", Bench_Batch },
+	{ "reader", Bench_Reader },
+	{ "allocations", Bench_Allocations },
+	{ "version2", Bench_Version2 }
+};
+
+//Runs every benchmark or only the ones named on the command line,
+//--quick shrinks them so the run doubles as a smoke test for ctest,
+//--large makes the version 2 round trip write a file of more than 4 GB
+int main(int argc, char* argv[])
+{
+	BenchOptions options{};
+	vector<string_view> selected{};
+	
+	for (int i = 1; i < argc; i++)
+	{
+		string_view arg = argv[i];
+		
+		if (arg == "--quick") options.isQuick = true;
+		else if (arg == "--large") options.isLarge = true;
+		else selected.push_back(arg);
+	}
+	
+	error_code ec{};
+	
+	options.workDir = temp_directory_path(ec) / "kalamodel_bench";
+	remove_all(options.workDir, ec);
+	create_directories(options.workDir, ec);
+	
+	if (ec)
+	{
+		Log::Print("Failed to create '" + options.workDir.string() + "'!", "BENCH", LogType::LOG_ERROR);
+		return 1;
+	}
+	
+	bool isFailed{};
+	
+	for (const auto& b : BENCHES)
+	{
+		if (!selected.empty()
+			&& std::find(selected.begin(), selected.end(), b.name) == selected.end())
+		{
+			continue;
+		}
+		
+		Log::Print(string(b.name));
+		
+		if (!b.run(options))
+		{
+			Log::Print("Benchmark '" + string(b.name) + "' failed!", "BENCH", LogType::LOG_ERROR);
+			isFailed = true;
+		}
+	}
+	
+	remove_all(options.workDir, ec);
+	
+	return isFailed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace KalaModel
+{
+	using std::vector;
+	using std::string;
+	
+	class Audit
+	{
+	public:
+		//Fully validates a kmd file or every kmd file in a folder and its subfolders with
+		//one thread per core. Every block is read and checked with paranoid validation,
+		//so stored checksums, field ranges, vertex values and index ranges are all verified
+		static void Command_Verify(const vector<string>& params);
+		
+		//Prints the header, name index and checksum presence and the block summaries
+		//of a kmd file, only the header, tables and trailing sections are read
+		static void Command_Inspect(const vector<string>& params);
+		
+		//Same as Command_Inspect but prints a single JSON object for scripts
+		static void Command_InspectJSON(const vector<string>& params);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "KalaHeaders/import_kmd.hpp"
+
+namespace Assimp
+{
+	class Importer;
+}
+
+using KalaHeaders::KalaModelData::ModelBlock;
+
+namespace KalaModel
+{
+	using std::vector;
+	using std::string;
+	using std::filesystem::path;
+	
+	using Assimp::Importer;
+	
+	using u8 = uint8_t;
+	using u32 = uint32_t;
+	
+	struct ConvertOptions
+	{
+		//Downscale size stored to the kmd header, clamped to 0-8
+		u8 scaleFactor{};
+		
+		//Prints the info of every converted model
+		bool isVerbose{};
+		
+		//ConvertFile keeps at most one model block per worker thread in flight, and no more
+		//than 256 MB of them, instead of a window of two blocks per worker thread
+		bool isStreamed{};
+		
+		//Worker threads ConvertFile converts meshes on while the calling thread
+		//writes finished blocks, leave at 0 to use one per hardware thread
+		u32 threadCount{};
+		
+		//Importer to reuse for this conversion, leave empty
+		//to reuse one importer per calling thread instead
+		Importer* importer{};
+	};
+	
+	//In-process conversion API of KalaModelCore, all paths must be absolute
+	class Convert
+	{
+	public:
+		//Converts a model file to kmd model blocks
+		static bool ConvertScene(
+			const path& origin,
+			const ConvertOptions& options,
+			vector<ModelBlock>& outModels);
+			
+		//Converts a model file to an in-memory kmd binary
+		static bool ConvertScene(
+			const path& origin,
+			const ConvertOptions& options,
+			vector<u8>& outKMD);
+			
+		//Converts an in-memory model file to kmd model blocks,
+		//extensionHint is the origin model extension without the dot, for example 'fbx'
+		static bool ConvertScene(
+			const u8* data,
+			size_t dataSize,
+			const string& extensionHint,
+			const ConvertOptions& options,
+			vector<ModelBlock>& outModels);
+			
+		//Converts an in-memory model file to an in-memory kmd binary,
+		//extensionHint is the origin model extension without the dot, for example 'fbx'
+		static bool ConvertScene(
+			const u8* data,
+			size_t dataSize,
+			const string& extensionHint,
+			const ConvertOptions& options,
+			vector<u8>& outKMD);
+			
+		//Converts a model file and writes it to target as kmd,
+		//origin and target must already be verified
+		static bool ConvertFile(
+			const path& origin,
+			const path& target,
+			const ConvertOptions& options);
+			
+		//Returns true if origin is an existing and readable .gltf, .obj or .fbx file
+		static bool IsValidOrigin(const path& origin);
+		
+		//Returns true if target is a .kmd path inside a writable folder,
+		//set allowOverwrite to true if target is allowed to already exist
+		static bool IsValidTarget(
+			const path& target,
+			bool allowOverwrite);
+			
+		//Returns true if origin extension is one of the supported model extensions
+		static bool IsAllowedExtension(const path& origin);
+	};
+}
\ No newline at end of file
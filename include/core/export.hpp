@@ -0,0 +1,105 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "KalaHeaders/import_kmd.hpp"
+
+using KalaHeaders::KalaModelData::ModelBlock;
+
+namespace KalaModel
+{
+	using std::vector;
+	using std::ofstream;
+	using std::filesystem::path;
+	
+	using u8 = uint8_t;
+	using u32 = uint32_t;
+	using u64 = uint64_t;
+	
+	class Export
+	{
+	public:
+		//Export as kmf, returns false if the models could not be written. The file is written
+		//next to the target and renamed over it, so a failed export keeps the previous file
+		static bool ExportKMF(
+			const path& targetPath,
+			u8 scaleFactor,
+			vector<ModelBlock>& modelBlocks);
+			
+		//Builds the full kmf binary in memory without writing it to disk
+		static bool BuildKMF(
+			u8 scaleFactor,
+			const vector<ModelBlock>& modelBlocks,
+			vector<u8>& output);
+	};
+	
+	//Writes a kmf one model block at a time so only the current block has to be
+	//kept in memory, the header and model table are reserved in Open and patched in Finish.
+	//Blocks are written to target + ".tmp", which only replaces the target once Finish succeeds,
+	//so readers never see a partial file and a failed export keeps the previous one
+	class ExportStream
+	{
+	public:
+		ExportStream() = default;
+		
+		//Removes the temporary file if Finish was never reached
+		~ExportStream();
+		
+		ExportStream(const ExportStream&) = delete;
+		ExportStream& operator=(const ExportStream&) = delete;
+		
+		//Creates the temporary file and reserves the header and model table for modelCount models.
+		//The file is written as version 1 unless modelCount or expectedBlocksSize,
+		//the total serialized size of all blocks, exceed its limits, blocks past
+		//the version 1 limits fail to write if expectedBlocksSize was too small
+		bool Open(
+			const path& targetPath,
+			u8 scaleFactor,
+			u32 modelCount,
+			u64 expectedBlocksSize = 0);
+			
+		//Appends the block to the file, the block can be freed right after
+		bool WriteBlock(const ModelBlock& block);
+		
+		//Appends a block that was already serialized with SerializeBlock,
+		//blocks must be written in the same order as in the model table
+		bool WriteBlockData(
+			const char* nodeName,
+			const vector<u8>& blockData);
+			
+		//Serializes a block to its kmf bytes, safe to call from any thread
+		static void SerializeBlock(
+			const ModelBlock& block,
+			vector<u8>& outBlockData);
+		
+		//Patches the header and model table and renames the temporary file over the target,
+		//fails if fewer than modelCount blocks were written
+		bool Finish();
+	private:
+		ofstream file{};
+		path targetPath{};
+		path tempPath{};
+		
+		u8 scaleFactor{};
+		u8 version{};
+		u32 modelCount{};
+		u32 writtenCount{};
+		u64 blocksSize{};
+		
+		vector<u8> modelTable{};
+		vector<u8> blockBuffer{};
+		
+		//CRC32C of every written block in table order
+		vector<u32> checksums{};
+		
+		//Closes and deletes the temporary file
+		void Discard();
+	};
+}
\ No newline at end of file
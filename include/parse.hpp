@@ -22,5 +22,9 @@ namespace KalaModel
 		//Compiles models to kmf for runtime use
 		//with the help of Assimp with additional verbose logging.
 		static void Command_VerboseParse(const vector<string>& params);
+		
+		//Compiles models to kmf one model at a time with bounded memory use,
+		//for scenes that would not fit in memory as a whole.
+		static void Command_StreamParse(const vector<string>& params);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace KalaModel
+{
+	using std::vector;
+	using std::string;
+	
+	using u8 = uint8_t;
+	using u16 = uint16_t;
+	using u32 = uint32_t;
+	using u64 = uint64_t;
+	
+	//Magic at the start of every serve request and response, 'KMSV'
+	constexpr u32 SERVE_MAGIC = 0x56534D4B;
+	
+	//Size of the fixed request header before the request payload
+	constexpr u8 SERVE_REQUEST_HEADER_SIZE = 16u;
+	
+	//Size of the fixed response header before the response message
+	constexpr u8 SERVE_RESPONSE_HEADER_SIZE = 32u;
+	
+	//Max allowed source payload of a request in bytes (512 MB), larger
+	//requests are answered with an error before anything is allocated for them
+	constexpr u32 MAX_SERVE_SOURCE_SIZE = 536870912u;
+
+	//What the request source payload contains
+	enum class ServeSource : u8
+	{
+		SOURCE_PATH  = 0, //absolute path to the origin model on the server machine
+		SOURCE_BYTES = 1  //the full origin model file, requires an extension hint
+	};
+	
+	//Where the server places the compiled kmd
+	enum class ServeResult : u8
+	{
+		RESULT_PATH          = 0, //written to the requested absolute target path
+		RESULT_SHARED_MEMORY = 1  //copied to a named shared memory segment
+	};
+	
+	//Request layout, all values are little-endian:
+	//  0  | 4 | magic
+	//  4  | 1 | source type
+	//  5  | 1 | result type
+	//  6  | 1 | downscale size
+	//  7  | 1 | unused
+	//  8  | 4 | source size
+	//  12 | 2 | extension hint size
+	//  14 | 2 | target path size
+	//  16 | ? | source, extension hint, target path
+	struct ServeRequest
+	{
+		ServeSource sourceType{};
+		ServeResult resultType{};
+		u8 scaleFactor{};
+		vector<u8> source{};
+		string extensionHint{};
+		string target{};
+	};
+	
+	//Response layout, all values are little-endian:
+	//  0  | 4 | magic
+	//  4  | 1 | 1 if the model was compiled, 0 if it failed
+	//  5  | 3 | unused
+	//  8  | 4 | queue depth when the request was received
+	//  12 | 4 | time spent in queue in microseconds
+	//  16 | 4 | time spent compiling in microseconds
+	//  20 | 8 | compiled kmd size in bytes
+	//  28 | 4 | message size
+	//  32 | ? | message - target path, shared memory name or error
+	struct ServeResponse
+	{
+		bool success{};
+		u32 queueDepth{};
+		u32 queueMicros{};
+		u32 convertMicros{};
+		u64 resultSize{};
+		string message{};
+	};
+	
+	class Serve
+	{
+	public:
+		//Runs a local conversion server on a unix domain socket until the process is closed
+		static void Command_Serve(const vector<string>& params);
+		
+		//Test client that asks the server to compile a model from path to path
+		static void Command_SendPath(const vector<string>& params);
+		
+		//Test client that uploads model bytes to the server
+		//and receives the compiled kmd through shared memory
+		static void Command_SendBytes(const vector<string>& params);
+	};
+}
\ No newline at end of file
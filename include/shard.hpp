@@ -0,0 +1,29 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace KalaModel
+{
+	using std::vector;
+	using std::string;
+	
+	class Shard
+	{
+	public:
+		//Splits a manifest of models into a shared job folder and compiles
+		//them with several worker processes, then merges their results.
+		//Each manifest line is 'scale<TAB>origin path<TAB>target path',
+		//relative paths are relative to the manifest folder, lines starting with '#' are skipped
+		static void Command_Shard(const vector<string>& params);
+		
+		//Claims and compiles jobs from a shared job folder until it is empty,
+		//can also be started manually on other machines that share the job folder
+		static void Command_ShardWorker(const vector<string>& params);
+	};
+}
\ No newline at end of file
@@ -6,26 +6,18 @@
 #pragma once
 
 #include <vector>
-#include <filesystem>
-
-#include "KalaHeaders/import_kmd.hpp"
-
-using KalaHeaders::KalaModelData::ModelBlock;
+#include <string>
 
 namespace KalaModel
 {
 	using std::vector;
-	using std::filesystem::path;
-	
-	using u8 = uint8_t;
+	using std::string;
 	
-	class Export
+	class Watch
 	{
 	public:
-		//Export as kmf
-		static void ExportKMF(
-			const path& targetPath,
-			u8 scaleFactor,
-			vector<ModelBlock>& modelBlocks);
+		//Keeps the converter running and recompiles every model in the origin folder
+		//to kmd in the target folder whenever it is saved, until the process is closed.
+		static void Command_Watch(const vector<string>& params);
 	};
 }
\ No newline at end of file
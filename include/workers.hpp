@@ -0,0 +1,41 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#pragma once
+
+#include <functional>
+
+namespace Assimp
+{
+	class Importer;
+}
+
+namespace KalaModel
+{
+	using std::function;
+	
+	using Assimp::Importer;
+	
+	using u32 = uint32_t;
+	
+	//Persistent conversion threads shared by every long-running command
+	class Workers
+	{
+	public:
+		//Starts the conversion threads once per process, each thread owns one Assimp importer
+		//that is reused for every job it runs. Does nothing if the threads already exist.
+		static void Start(u32 count);
+		
+		//Queues a job to the first free conversion thread,
+		//the job receives the importer owned by that thread
+		static void Submit(function<void(Importer&)> job);
+		
+		//Returns the count of queued jobs that have not started yet
+		static size_t GetQueueDepth();
+		
+		//Returns the count of running conversion threads
+		static u32 GetWorkerCount();
+	};
+}
\ No newline at end of file
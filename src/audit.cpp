@@ -0,0 +1,652 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/import_kmd.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "audit.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaModelData::KmdFile;
+using KalaHeaders::KalaModelData::ModelHeader;
+using KalaHeaders::KalaModelData::ModelTable;
+using KalaHeaders::KalaModelData::ModelBlock;
+using KalaHeaders::KalaModelData::ImportResult;
+using KalaHeaders::KalaModelData::ValidationMode;
+using KalaHeaders::KalaModelData::ResultToString;
+using KalaHeaders::KalaModelData::FixedNameView;
+using KalaHeaders::KalaModelData::FindBlockChecksum;
+using KalaHeaders::KalaModelData::GetHeaderSize;
+using KalaHeaders::KalaModelData::GetTableSize;
+using KalaHeaders::KalaModelData::IsInsideRegion;
+using KalaHeaders::KalaModelData::MAX_COALESCED_READ_SIZE;
+using KalaHeaders::KalaModelData::GetLoaderPool;
+using KalaHeaders::KalaThread::TaskGroup;
+
+using KalaCLI::Core;
+
+using KalaModel::Audit;
+
+using std::vector;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::ostringstream;
+using std::hex;
+using std::dec;
+using std::setw;
+using std::setfill;
+using std::atomic;
+using std::thread;
+using std::min;
+using std::max;
+using std::sort;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::milli;
+using std::filesystem::path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::is_directory;
+using std::filesystem::is_regular_file;
+using std::filesystem::recursive_directory_iterator;
+using std::filesystem::directory_options;
+using std::error_code;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Max count of verify threads, files are independent so more only helps on very fast storage
+constexpr u32 MAX_VERIFY_THREADS = 64u;
+
+struct VerifyResult
+{
+	path file{};
+	ImportResult result = ImportResult::RESULT_SUCCESS;
+	
+	u64 fileSize{};
+	u64 modelCount{};
+	u64 vertexCount{};
+	u64 indexCount{};
+	bool hasChecksums{};
+	
+	//model whose block failed to verify, -1 if the header or tables failed
+	long long failedModel = -1;
+	string failedModelName{};
+};
+
+static void PrintError(
+	const string& message,
+	const string& target)
+{
+	Log::Print(
+		message,
+		target,
+		LogType::LOG_ERROR,
+		2);
+}
+
+//Prints every line on its own since a single print is capped in length
+static void PrintLines(const string& text)
+{
+	size_t start{};
+	while (start < text.size())
+	{
+		size_t end = text.find('\n', start);
+		if (end == string::npos) end = text.size();
+		
+		if (end > start) Log::Print(string_view(text).substr(start, end - start));
+		
+		start = end + 1;
+	}
+}
+
+static string NodeName(const ModelTable& t)
+{
+	return string(FixedNameView(
+		rcast<const u8*>(t.nodeName),
+		sizeof(t.nodeName)));
+}
+
+//Returns the inserted path as a kmd file or every kmd file in the folder and its subfolders
+static bool CollectFiles(
+	const path& origin,
+	vector<path>& outFiles)
+{
+	error_code ec{};
+	
+	if (is_regular_file(origin, ec))
+	{
+		outFiles.push_back(origin);
+		return true;
+	}
+	
+	if (!is_directory(origin, ec)) return false;
+	
+	for (recursive_directory_iterator it(origin, directory_options::skip_permission_denied, ec), end;
+		it != end;
+		it.increment(ec))
+	{
+		if (ec) break;
+		
+		if (it->is_regular_file(ec)
+			&& it->path().extension() == ".kmd")
+		{
+			outFiles.push_back(it->path());
+		}
+	}
+	
+	sort(outFiles.begin(), outFiles.end());
+	
+	return true;
+}
+
+//Checks what KmdFile::Open leaves to the block reads, the tables must fill the table region
+//exactly and every block must start after the tables and end inside the block region
+static ImportResult VerifyLayout(const KmdFile& file)
+{
+	const ModelHeader& header = file.GetHeader();
+	const vector<ModelTable>& tables = file.GetTables();
+	
+	if (header.modelCount == 0
+		|| header.modelCount != tables.size())
+	{
+		return ImportResult::RESULT_INVALID_MODEL_COUNT;
+	}
+	if (scast<u64>(header.modelCount) * GetTableSize(header.version) != header.modelTablesSize)
+	{
+		return ImportResult::RESULT_INVALID_MODEL_TABLE_SIZE;
+	}
+	
+	//the region is compared as a difference so a size near 2^64 can't wrap past the check
+	u64 regionStart = GetHeaderSize(header.version) + header.modelTablesSize;
+	u64 regionSize = header.modelBlocksSize;
+	u64 fileSize = file.GetFileSize();
+	
+	if (regionStart > fileSize
+		|| regionSize > fileSize - regionStart)
+	{
+		return ImportResult::RESULT_UNEXPECTED_EOF;
+	}
+	
+	for (const auto& t : tables)
+	{
+		if (!IsInsideRegion(
+			t.blockOffset,
+			t.blockSize,
+			regionStart,
+			regionSize))
+		{
+			return ImportResult::RESULT_INVALID_MODEL_BLOCK_SIZE;
+		}
+	}
+	
+	return ImportResult::RESULT_SUCCESS;
+}
+
+//Reads and validates every block of the file in batches of up to MAX_COALESCED_READ_SIZE
+//bytes so memory stays bounded, a failed batch is read again one block at a time to find the model
+static VerifyResult VerifyFile(const path& inFile)
+{
+	VerifyResult r{};
+	r.file = inFile;
+	
+	KmdFile file{};
+	
+	r.result = file.Open(inFile, ValidationMode::VALIDATION_PARANOID);
+	if (r.result != ImportResult::RESULT_SUCCESS) return r;
+	
+	r.fileSize = file.GetFileSize();
+	r.hasChecksums = !file.GetChecksums().empty();
+	
+	r.result = VerifyLayout(file);
+	if (r.result != ImportResult::RESULT_SUCCESS) return r;
+	
+	const vector<ModelTable>& tables = file.GetTables();
+	r.modelCount = tables.size();
+	
+	vector<ModelTable> batch{};
+	vector<ModelBlock> blocks{};
+	
+	size_t first{};
+	while (first < tables.size())
+	{
+		batch.clear();
+		
+		u64 batchSize{};
+		size_t last = first;
+		while (last < tables.size()
+			&& (batch.empty()
+			|| batchSize + tables[last].blockSize <= MAX_COALESCED_READ_SIZE))
+		{
+			batch.push_back(tables[last]);
+			batchSize += tables[last].blockSize;
+			last++;
+		}
+		
+		ImportResult batchResult = file.ReadBlocks(batch, blocks);
+		if (batchResult != ImportResult::RESULT_SUCCESS)
+		{
+			r.result = batchResult;
+			
+			for (size_t i = first; i < last; i++)
+			{
+				batch.assign(1, tables[i]);
+				
+				ImportResult blockResult = file.ReadBlocks(batch, blocks);
+				if (blockResult != ImportResult::RESULT_SUCCESS)
+				{
+					r.result = blockResult;
+					r.failedModel = scast<long long>(i);
+					r.failedModelName = NodeName(tables[i]);
+					
+					break;
+				}
+			}
+			
+			return r;
+		}
+		
+		for (const auto& b : blocks)
+		{
+			r.vertexCount += b.vertices.size();
+			r.indexCount += b.indices.size();
+		}
+		
+		first = last;
+	}
+	
+	return r;
+}
+
+//Returns the length of the valid UTF-8 sequence at the start of value or 0 if it is invalid,
+//overlong forms, surrogates and code points past U+10FFFF are invalid
+static size_t GetUTF8Length(string_view value)
+{
+	u8 lead = scast<u8>(value[0]);
+	if (lead < 0x80) return 1;
+	
+	size_t length{};
+	u32 codePoint{};
+	u32 minCodePoint{};
+	
+	if ((lead & 0xE0) == 0xC0)
+	{
+		length = 2;
+		codePoint = lead & 0x1F;
+		minCodePoint = 0x80;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		length = 3;
+		codePoint = lead & 0x0F;
+		minCodePoint = 0x800;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		length = 4;
+		codePoint = lead & 0x07;
+		minCodePoint = 0x10000;
+	}
+	else return 0;
+	
+	if (value.size() < length) return 0;
+	
+	for (size_t i = 1; i < length; i++)
+	{
+		u8 next = scast<u8>(value[i]);
+		if ((next & 0xC0) != 0x80) return 0;
+		
+		codePoint = (codePoint << 6) | (next & 0x3F);
+	}
+	
+	if (codePoint < minCodePoint
+		|| codePoint > 0x10FFFF
+		|| (codePoint >= 0xD800
+		&& codePoint <= 0xDFFF))
+	{
+		return 0;
+	}
+	
+	return length;
+}
+
+//Escapes a string for a JSON string value, bytes that are not valid UTF-8
+//become U+FFFD so paths in any encoding still produce valid JSON
+static string EscapeJSON(string_view value)
+{
+	ostringstream oss{};
+	
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		char c = value[i];
+		
+		if (scast<u8>(c) >= 0x80)
+		{
+			size_t length = GetUTF8Length(value.substr(i));
+			
+			if (length == 0) oss << "\\ufffd";
+			else
+			{
+				oss << value.substr(i, length);
+				i += length - 1;
+			}
+			
+			continue;
+		}
+		
+		switch (c)
+		{
+		case '"':  oss << "\\\""; break;
+		case '\\': oss << "\\\\"; break;
+		case '\n': oss << "\\n"; break;
+		case '\r': oss << "\\r"; break;
+		case '\t': oss << "\\t"; break;
+		default:
+			if (scast<u8>(c) < 0x20)
+			{
+				oss << "\\u" << hex << setw(4) << setfill('0') << scast<u32>(scast<u8>(c)) << dec;
+			}
+			else oss << c;
+		}
+	}
+	
+	return oss.str();
+}
+
+static string ToHex(u32 value)
+{
+	ostringstream oss{};
+	oss << "0x" << hex << setw(8) << setfill('0') << value;
+	
+	return oss.str();
+}
+
+//Block sizes and the unused bytes between blocks, computed from the tables alone
+struct BlockSummary
+{
+	u64 minSize{};
+	u64 maxSize{};
+	u64 totalSize{};
+	u64 gapBytes{};     //block region bytes that no table points to
+	u64 overlapCount{}; //blocks that start before the previous block in file order ends
+};
+
+static BlockSummary SummarizeBlocks(const KmdFile& file)
+{
+	const vector<ModelTable>& tables = file.GetTables();
+	
+	BlockSummary s{};
+	if (tables.empty()) return s;
+	
+	vector<ModelTable> sorted = tables;
+	sort(sorted.begin(), sorted.end(),
+		[](const ModelTable& a, const ModelTable& b) { return a.blockOffset < b.blockOffset; });
+	
+	s.minSize = sorted[0].blockSize;
+	
+	u64 regionStart = GetHeaderSize(file.GetHeader().version) + file.GetHeader().modelTablesSize;
+	u64 end = regionStart;
+	
+	for (const auto& t : sorted)
+	{
+		s.minSize = min(s.minSize, scast<u64>(t.blockSize));
+		s.maxSize = max(s.maxSize, scast<u64>(t.blockSize));
+		s.totalSize += t.blockSize;
+		
+		if (t.blockOffset < end) s.overlapCount++;
+		else s.gapBytes += t.blockOffset - end;
+		
+		end = max(end, t.blockOffset + scast<u64>(t.blockSize));
+	}
+	
+	u64 regionEnd = regionStart + file.GetHeader().modelBlocksSize;
+	if (regionEnd > end) s.gapBytes += regionEnd - end;
+	
+	return s;
+}
+
+static void Inspect(
+	const vector<string>& params,
+	bool isJSON)
+{
+	path target = weakly_canonical(path(Core::currentDir) / params[1]);
+	
+	KmdFile file{};
+	ImportResult openResult = file.Open(target);
+	
+	if (openResult != ImportResult::RESULT_SUCCESS)
+	{
+		if (isJSON)
+		{
+			Log::Print(
+				"{\"file\":\"" + EscapeJSON(target.string())
+				+ "\",\"result\":\"" + ResultToString(openResult) + "\"}");
+		}
+		else
+		{
+			PrintError(
+				"Failed to inspect '" + target.string() + "'! Reason: " + ResultToString(openResult),
+				"INSPECT");
+		}
+		
+		return;
+	}
+	
+	const ModelHeader& header = file.GetHeader();
+	const vector<ModelTable>& tables = file.GetTables();
+	const auto& checksums = file.GetChecksums();
+	
+	BlockSummary s = SummarizeBlocks(file);
+	
+	ostringstream oss{};
+	
+	if (isJSON)
+	{
+		//one model per line so the output can also be read line by line
+		oss << "{\"file\":\"" << EscapeJSON(target.string()) << "\""
+			<< ",\"result\":\"" << ResultToString(openResult) << "\""
+			<< ",\"fileSize\":" << file.GetFileSize()
+			<< ",\"version\":" << scast<u32>(header.version)
+			<< ",\"scaleFactor\":" << scast<u32>(header.scaleFactor)
+			<< ",\"modelCount\":" << header.modelCount
+			<< ",\"modelTablesSize\":" << header.modelTablesSize
+			<< ",\"modelBlocksSize\":" << header.modelBlocksSize
+			<< ",\"hasNameIndex\":" << (file.GetNameIndex().empty() ? "false" : "true")
+			<< ",\"hasChecksums\":" << (checksums.empty() ? "false" : "true")
+			<< ",\"blocks\":{\"minSize\":" << s.minSize
+			<< ",\"maxSize\":" << s.maxSize
+			<< ",\"totalSize\":" << s.totalSize
+			<< ",\"gapBytes\":" << s.gapBytes
+			<< ",\"overlapCount\":" << s.overlapCount << "}"
+			<< ",\"models\":[\n";
+		
+		for (size_t i = 0; i < tables.size(); i++)
+		{
+			const ModelTable& t = tables[i];
+			const u32* checksum = FindBlockChecksum(checksums, t.blockOffset);
+			
+			oss << "{\"index\":" << i
+				<< ",\"nodeName\":\"" << EscapeJSON(NodeName(t)) << "\""
+				<< ",\"blockOffset\":" << t.blockOffset
+				<< ",\"blockSize\":" << t.blockSize
+				<< ",\"checksum\":" << (checksum ? "\"" + ToHex(*checksum) + "\"" : "null")
+				<< "}" << (i + 1 < tables.size() ? "," : "") << "\n";
+		}
+		
+		oss << "]}";
+		
+		PrintLines(oss.str());
+		
+		return;
+	}
+	
+	oss << "file:            " << target.string() << "\n"
+		<< "file size:       " << file.GetFileSize() << " bytes\n"
+		<< "version:         " << scast<u32>(header.version) << "\n"
+		<< "scale factor:    " << scast<u32>(header.scaleFactor) << "\n"
+		<< "models:          " << header.modelCount << "\n"
+		<< "tables size:     " << header.modelTablesSize << " bytes\n"
+		<< "blocks size:     " << header.modelBlocksSize << " bytes\n"
+		<< "name index:      " << (file.GetNameIndex().empty() ? "no" : "yes") << "\n"
+		<< "checksums:       " << (checksums.empty() ? "no" : "yes") << "\n"
+		<< "block size:      " << s.minSize << " min, " << s.maxSize << " max, "
+		<< (tables.empty() ? 0 : s.totalSize / tables.size()) << " average\n"
+		<< "unused bytes:    " << s.gapBytes << "\n"
+		<< "overlaps:        " << s.overlapCount << "\n\n"
+		<< "models:\n";
+	
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		const ModelTable& t = tables[i];
+		const u32* checksum = FindBlockChecksum(checksums, t.blockOffset);
+		
+		oss << "  " << i << ": '" << NodeName(t) << "' offset " << t.blockOffset
+			<< ", size " << t.blockSize;
+		
+		if (checksum) oss << ", crc32c " << ToHex(*checksum);
+		
+		oss << "\n";
+	}
+	
+	PrintLines(oss.str());
+}
+
+namespace KalaModel
+{
+	void Audit::Command_Verify(const vector<string>& params)
+	{
+		path origin = weakly_canonical(path(Core::currentDir) / params[1]);
+		
+		vector<path> files{};
+		if (!CollectFiles(origin, files))
+		{
+			PrintError("Failed to verify because '" + origin.string() + "' is not a file or folder!", "VERIFY");
+			return;
+		}
+		
+		if (files.empty())
+		{
+			PrintError("Failed to verify because '" + origin.string() + "' has no kmd files!", "VERIFY");
+			return;
+		}
+		
+		u32 threadCount = min(
+			max(thread::hardware_concurrency(), 1u),
+			min(scast<u32>(files.size()), MAX_VERIFY_THREADS));
+		
+		Log::Print(
+			"Verifying " + to_string(files.size()) + " files with " + to_string(threadCount) + " threads.",
+			"VERIFY",
+			LogType::LOG_INFO);
+		
+		vector<VerifyResult> results(files.size());
+		atomic<size_t> nextIndex{};
+		
+		auto start = steady_clock::now();
+		
+		auto work = [&]()
+		{
+			for (size_t i = nextIndex++; i < files.size(); i = nextIndex++)
+			{
+				results[i] = VerifyFile(files[i]);
+			}
+		};
+		
+		//a single file or hardware thread is verified inline without starting the loader pool,
+		//otherwise the calling thread verifies too and the pool runs the rest
+		if (threadCount <= 1) work();
+		else
+		{
+			TaskGroup group(GetLoaderPool());
+			
+			try
+			{
+				for (u32 i = 1; i < threadCount; i++) group.run(work);
+			}
+			catch (...)
+			{
+				//fewer tasks only makes the verify slower
+			}
+			
+			work();
+			
+			group.wait();
+		}
+		
+		f64 wallMilliseconds = duration<f64, milli>(steady_clock::now() - start).count();
+		f64 seconds = max(wallMilliseconds / 1000.0, 1e-9);
+		
+		size_t passed{};
+		size_t withChecksums{};
+		u64 totalBytes{};
+		u64 totalModels{};
+		u64 totalVertices{};
+		u64 totalIndices{};
+		
+		for (const auto& r : results)
+		{
+			if (r.result == ImportResult::RESULT_SUCCESS) passed++;
+			else
+			{
+				string message = "Failed to verify '" + r.file.string() + "'";
+				if (r.failedModel >= 0)
+				{
+					message += " at model " + to_string(r.failedModel) + " '" + r.failedModelName + "'";
+				}
+				
+				PrintError(message + "! Reason: " + ResultToString(r.result), "VERIFY");
+			}
+			
+			if (r.hasChecksums) withChecksums++;
+			
+			totalBytes += r.fileSize;
+			totalModels += r.modelCount;
+			totalVertices += r.vertexCount;
+			totalIndices += r.indexCount;
+		}
+		
+		ostringstream oss{};
+		
+		oss << "files:           " << files.size() << "\n"
+			<< "passed:          " << passed << "\n"
+			<< "failed:          " << files.size() - passed << "\n"
+			<< "with checksums:  " << withChecksums << "\n"
+			<< "models:          " << totalModels << "\n"
+			<< "vertices:        " << totalVertices << "\n"
+			<< "indices:         " << totalIndices << "\n"
+			<< "threads:         " << threadCount << "\n"
+			<< "wall time:       " << wallMilliseconds << " ms\n"
+			<< "throughput:      " << scast<f64>(files.size()) / seconds << " files/s, "
+			<< scast<f64>(totalBytes) / (1024.0 * 1024.0) / seconds << " MB/s";
+		
+		Log::Print(oss.str());
+	}
+	
+	void Audit::Command_Inspect(const vector<string>& params)
+	{
+		Inspect(params, false);
+	}
+	
+	void Audit::Command_InspectJSON(const vector<string>& params)
+	{
+		Inspect(params, true);
+	}
+}
\ No newline at end of file
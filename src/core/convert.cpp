@@ -0,0 +1,1041 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <array>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#include "Assimp/include/Importer.hpp"
+#include "Assimp/include/scene.h"
+#include "Assimp/include/postprocess.h"
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/math_utils.hpp"
+#include "KalaHeaders/string_utils.hpp"
+#include "KalaHeaders/import_kmd.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+
+#include "convert.hpp"
+#include "export.hpp"
+
+using Assimp::Importer;
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaMath::vec2;
+using KalaHeaders::KalaMath::vec3;
+using KalaHeaders::KalaMath::vec4;
+using KalaHeaders::KalaMath::normalize;
+using KalaHeaders::KalaMath::dot;
+using KalaHeaders::KalaMath::length;
+using KalaHeaders::KalaMath::cross;
+using KalaHeaders::KalaString::StringToCharArray;
+using KalaHeaders::KalaString::ZeroPadCharArray;
+using KalaHeaders::KalaModelData::ModelBlock;
+using KalaHeaders::KalaModelData::Vertex;
+using KalaHeaders::KalaModelData::VERTICE_DATA_OFFSET;
+using KalaHeaders::KalaThread::jthread;
+
+using KalaModel::Convert;
+using KalaModel::ConvertOptions;
+using KalaModel::Export;
+using KalaModel::ExportStream;
+
+using std::vector;
+using std::array;
+using std::string;
+using std::string_view;
+using std::to_string;
+using std::ostringstream;
+using std::clamp;
+using std::find;
+using std::move;
+using std::min;
+using std::max;
+using std::map;
+using std::mutex;
+using std::scoped_lock;
+using std::unique_lock;
+using std::condition_variable;
+using std::atomic;
+using std::thread;
+using std::milli;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::filesystem::path;
+using std::filesystem::is_regular_file;
+using std::filesystem::exists;
+using std::filesystem::status;
+using std::filesystem::perms;
+
+//Adjusts final imported model size by this scale
+constexpr f32 SCALE_MULTIPLIER = 0.01f;
+
+//Max serialized bytes of model blocks a streamed conversion keeps claimed by its workers
+//or waiting for the writer, a single larger block is still converted on its own
+constexpr u64 MAX_STREAMED_WINDOW_BYTES = 268435456u;
+
+//Assimp post-processing steps applied to every imported scene
+constexpr unsigned int IMPORT_FLAGS =
+	aiProcess_Triangulate
+	| aiProcess_GenSmoothNormals
+	| aiProcess_FlipUVs
+	| aiProcess_JoinIdenticalVertices;
+
+constexpr array<string_view, 3> allowedExtensions
+{
+	".fbx",
+	".obj",
+	".gltf"
+};
+
+struct Mesh
+{
+	aiMesh* mesh{};
+	string meshName{};
+};
+struct Node
+{
+	aiNode* node{};
+	string nodeName{};
+	string nodePath{};
+	vector<Mesh> meshes{};
+};
+
+struct PipelineTask
+{
+	const Node* node{};
+	u32 meshIndex{};
+	u64 blockSize{}; //serialized size of the block
+};
+struct PipelineBlock
+{
+	string nodeName{};
+	vector<u8> data{};
+};
+//Busy milliseconds of each pipeline stage, summed over all threads
+struct PipelineStats
+{
+	atomic<f64> convert{};
+	atomic<f64> tangents{};
+	atomic<f64> serialize{};
+	atomic<f64> write{};
+};
+
+static bool ConvertImportedScene(
+	const aiScene* scene,
+	const string& sourceName,
+	bool isVerbose,
+	vector<ModelBlock>& outModels);
+	
+//Converts, serializes and writes model blocks as a pipeline, worker threads
+//convert meshes while the calling thread writes finished blocks in order
+static bool PipelineImportedScene(
+	const aiScene* scene,
+	const string& sourceName,
+	const path& target,
+	const ConvertOptions& options);
+	
+//Returns the milliseconds since stageStart and moves stageStart to now
+static f64 AddElapsed(steady_clock::time_point& stageStart);
+	
+static bool GetSceneNodes(
+	const aiScene* scene,
+	const string& sourceName,
+	vector<Node>& outNodes);
+	
+static void BuildModelBlock(
+	const Node& n,
+	const Mesh& m,
+	ModelBlock& b);
+	
+static void GenerateTangents(ModelBlock& b);
+
+static void PrintModelInfo(const ModelBlock& m);
+
+//Frees the vertex and face arrays of an already converted aiMesh
+//so streamed conversions don't keep the whole scene in memory
+static void ReleaseMeshData(aiMesh* mesh);
+
+//Returns the peak resident memory of this process in bytes
+static size_t GetPeakMemoryBytes();
+
+static void GetAllNodes(
+	const aiScene* scene, 
+	aiNode* node, 
+	vector<Node>& out);
+	
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"PARSE",
+		LogType::LOG_ERROR,
+		2);
+}
+
+//Returns the importer passed in options or the importer owned by the calling thread
+static Importer& GetImporter(const ConvertOptions& options)
+{
+	thread_local Importer threadImporter{};
+	
+	return options.importer
+		? *options.importer
+		: threadImporter;
+}
+
+static u8 ClampScaleFactor(u8 scaleFactor)
+{
+	return clamp(scaleFactor, u8{ 0 }, u8{ 8 });
+}
+
+namespace KalaModel
+{
+	bool Convert::ConvertScene(
+		const path& origin,
+		const ConvertOptions& options,
+		vector<ModelBlock>& outModels)
+	{
+		Importer& importer = GetImporter(options);
+		
+		const aiScene* scene = importer.ReadFile(
+			origin.string(),
+			IMPORT_FLAGS);
+			
+		bool converted = ConvertImportedScene(
+			scene,
+			origin.string(),
+			options.isVerbose,
+			outModels);
+			
+		importer.FreeScene();
+		
+		return converted;
+	}
+	
+	bool Convert::ConvertScene(
+		const path& origin,
+		const ConvertOptions& options,
+		vector<u8>& outKMD)
+	{
+		vector<ModelBlock> models{};
+		
+		return ConvertScene(origin, options, models)
+			&& Export::BuildKMF(
+				ClampScaleFactor(options.scaleFactor),
+				models,
+				outKMD);
+	}
+	
+	bool Convert::ConvertScene(
+		const u8* data,
+		size_t dataSize,
+		const string& extensionHint,
+		const ConvertOptions& options,
+		vector<ModelBlock>& outModels)
+	{
+		Importer& importer = GetImporter(options);
+		
+		const aiScene* scene = importer.ReadFileFromMemory(
+			data,
+			dataSize,
+			IMPORT_FLAGS,
+			extensionHint.c_str());
+			
+		bool converted = ConvertImportedScene(
+			scene,
+			"<memory>." + extensionHint,
+			options.isVerbose,
+			outModels);
+			
+		importer.FreeScene();
+		
+		return converted;
+	}
+	
+	bool Convert::ConvertScene(
+		const u8* data,
+		size_t dataSize,
+		const string& extensionHint,
+		const ConvertOptions& options,
+		vector<u8>& outKMD)
+	{
+		vector<ModelBlock> models{};
+		
+		return ConvertScene(data, dataSize, extensionHint, options, models)
+			&& Export::BuildKMF(
+				ClampScaleFactor(options.scaleFactor),
+				models,
+				outKMD);
+	}
+	
+	bool Convert::ConvertFile(
+		const path& origin,
+		const path& target,
+		const ConvertOptions& options)
+	{
+		Importer& importer = GetImporter(options);
+		
+		const aiScene* scene = importer.ReadFile(
+			origin.string(),
+			IMPORT_FLAGS);
+			
+		bool converted = PipelineImportedScene(
+			scene,
+			origin.string(),
+			target,
+			options);
+			
+		importer.FreeScene();
+		
+		return converted;
+	}
+	
+	bool Convert::IsValidOrigin(const path& origin)
+	{
+		if (!exists(origin))
+		{
+			PrintError("Failed to load model because input path '" + origin.string() + "' does not exist!");
+			
+			return false;
+		}
+		
+		if (!is_regular_file(origin)
+			|| !origin.has_extension())
+		{
+			PrintError("Failed to load model because input path '" + origin.string() + "' is not a regular file!");
+			
+			return false;
+		}
+		
+		if (!IsAllowedExtension(origin))
+		{
+			PrintError("Failed to load model because input path '" + origin.string() + "' extension '" + origin.extension().string() + "' is not allowed!");
+			
+			return false;
+		}
+		
+		auto fileStatusOrigin = status(origin);
+		auto filePermsOrigin = fileStatusOrigin.permissions();
+		
+		bool canReadOrigin = (filePermsOrigin & (
+			perms::owner_read
+			| perms::group_read
+			| perms::others_read))
+			!= perms::none;
+			
+		if (!canReadOrigin)
+		{
+			PrintError("Failed to load model because you have insufficient read permissions for input path '" + origin.string() + "'!");
+			
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool Convert::IsValidTarget(
+		const path& target,
+		bool allowOverwrite)
+	{
+		if (!allowOverwrite
+			&& exists(target))
+		{
+			PrintError("Failed to load model because output path '" + target.string() + "' already exists!");
+			
+			return false;
+		}
+		
+		if (!target.has_extension()
+			|| target.extension() != ".kmd")
+		{
+			PrintError("Failed to load model because output path '" + target.string() + "' extension '" + target.extension().string() + "' is not allowed!");
+			
+			return false;
+		}
+		
+		auto fileStatusTarget = status(target.parent_path());
+		auto filePermsTarget = fileStatusTarget.permissions();
+		
+		bool canWriteTarget = (filePermsTarget & (
+			perms::owner_write
+			| perms::group_write
+			| perms::others_write))
+			!= perms::none;
+			
+		if (!canWriteTarget)
+		{
+			PrintError("Failed to load model because you have insufficient write permissions for output parent path '" + target.string() + "'!");
+			
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool Convert::IsAllowedExtension(const path& origin)
+	{
+		return find(
+			allowedExtensions.begin(),
+			allowedExtensions.end(),
+			origin.extension().string())
+			!= allowedExtensions.end();
+	}
+}
+
+bool ConvertImportedScene(
+	const aiScene* scene,
+	const string& sourceName,
+	bool isVerbose,
+	vector<ModelBlock>& outModels)
+{
+	vector<Node> nodes{};
+	
+	if (!GetSceneNodes(
+		scene,
+		sourceName,
+		nodes))
+	{
+		return false;
+	}
+	
+	vector<ModelBlock> models{};
+	
+	for (const auto& n : nodes)
+	{
+		for (const auto& m : n.meshes)
+		{
+			ModelBlock b{};
+			
+			BuildModelBlock(n, m, b);
+			GenerateTangents(b);
+			
+			if (isVerbose) PrintModelInfo(b);
+			
+			models.push_back(move(b));
+		}
+	}
+	
+	outModels = move(models);
+	
+	return true;
+}
+
+bool PipelineImportedScene(
+	const aiScene* scene,
+	const string& sourceName,
+	const path& target,
+	const ConvertOptions& options)
+{
+	auto pipelineStart = steady_clock::now();
+	
+	vector<Node> nodes{};
+	
+	if (!GetSceneNodes(
+		scene,
+		sourceName,
+		nodes))
+	{
+		return false;
+	}
+	
+	//one task per model block, in the same order as the model table
+	vector<PipelineTask> tasks{};
+	
+	for (const auto& n : nodes)
+	{
+		for (u32 i = 0; i < n.meshes.size(); i++)
+		{
+			tasks.push_back(
+			{
+				.node = &n,
+				.meshIndex = i
+			});
+		}
+	}
+	
+	//the same aiMesh can be instanced by several nodes,
+	//so its data is only released after its last use
+	vector<atomic<u32>> meshUses(scene->mNumMeshes);
+	
+	for (const auto& t : tasks)
+	{
+		meshUses[t.node->node->mMeshes[t.meshIndex]]++;
+	}
+	
+	//serialized size of all blocks, lets the stream pick the file version up front
+	u64 expectedBlocksSize{};
+	
+	for (auto& t : tasks)
+	{
+		const aiMesh* mesh = scene->mMeshes[t.node->node->mMeshes[t.meshIndex]];
+		
+		t.blockSize = VERTICE_DATA_OFFSET + u64(mesh->mNumVertices) * sizeof(Vertex);
+		
+		for (u32 f = 0; f < mesh->mNumFaces; f++)
+		{
+			t.blockSize += u64(mesh->mFaces[f].mNumIndices) * sizeof(u32);
+		}
+		
+		expectedBlocksSize += t.blockSize;
+	}
+	
+	ExportStream stream{};
+	
+	if (!stream.Open(
+		target,
+		ClampScaleFactor(options.scaleFactor),
+		scast<u32>(tasks.size()),
+		expectedBlocksSize))
+	{
+		return false;
+	}
+	
+	u32 threadCount = options.threadCount > 0
+		? options.threadCount
+		: max(thread::hardware_concurrency(), 1u);
+	threadCount = min(threadCount, max(scast<u32>(tasks.size()), 1u));
+	
+	//streamed conversions keep one block per worker and cap the bytes of the window,
+	//so every worker stays busy while memory stays bounded by MAX_STREAMED_WINDOW_BYTES
+	const u32 window = options.isStreamed
+		? threadCount
+		: threadCount * 2;
+		
+	mutex pipelineMutex{};
+	condition_variable readyCondition{};
+	condition_variable windowCondition{};
+	
+	map<u32, PipelineBlock> finished{};
+	u32 nextTask{};
+	u32 writtenCount{};
+	bool failed{};
+	
+	//serialized bytes of the blocks claimed by workers but not written yet
+	u64 windowBytes{};
+	
+	auto fitsWindow = [&]()
+		{
+			if (nextTask >= writtenCount + window) return false;
+			
+			return !options.isStreamed
+				|| windowBytes == 0
+				|| windowBytes + tasks[nextTask].blockSize <= MAX_STREAMED_WINDOW_BYTES;
+		};
+		
+	PipelineStats stats{};
+	
+	//
+	// CONVERT, TANGENT AND SERIALIZE STAGES
+	//
+	
+	auto runWorker = [&]()
+		{
+			while (true)
+			{
+				u32 index{};
+				
+				{
+					unique_lock lock(pipelineMutex);
+					windowCondition.wait(lock, [&]
+						{
+							return failed
+								|| nextTask == tasks.size()
+								|| fitsWindow();
+						});
+						
+					if (failed
+						|| nextTask == tasks.size())
+					{
+						return;
+					}
+					
+					index = nextTask++;
+					windowBytes += tasks[index].blockSize;
+				}
+				
+				const PipelineTask& task = tasks[index];
+				const Mesh& mesh = task.node->meshes[task.meshIndex];
+				
+				ModelBlock b{};
+				PipelineBlock out{};
+				
+				auto stageStart = steady_clock::now();
+				
+				BuildModelBlock(*task.node, mesh, b);
+				
+				if (--meshUses[task.node->node->mMeshes[task.meshIndex]] == 0) ReleaseMeshData(mesh.mesh);
+				
+				stats.convert += AddElapsed(stageStart);
+				
+				GenerateTangents(b);
+				
+				stats.tangents += AddElapsed(stageStart);
+				
+				if (options.isVerbose) PrintModelInfo(b);
+				
+				ExportStream::SerializeBlock(b, out.data);
+				out.nodeName.assign(b.nodeName, sizeof(b.nodeName));
+				
+				stats.serialize += AddElapsed(stageStart);
+				
+				{
+					scoped_lock lock(pipelineMutex);
+					finished.emplace(index, move(out));
+				}
+				readyCondition.notify_one();
+			}
+		};
+		
+	vector<thread> workers{};
+	for (u32 i = 0; i < threadCount; i++) workers.push_back(jthread(runWorker));
+	
+	//
+	// WRITE STAGE
+	//
+	
+	//the calling thread writes finished blocks in table order
+	//while the workers already process the next ones
+	for (u32 i = 0; i < tasks.size(); i++)
+	{
+		PipelineBlock block{};
+		
+		{
+			unique_lock lock(pipelineMutex);
+			readyCondition.wait(lock, [&] { return finished.contains(i); });
+			
+			block = move(finished.at(i));
+			finished.erase(i);
+		}
+		
+		auto stageStart = steady_clock::now();
+		
+		bool written = stream.WriteBlockData(
+			block.nodeName.c_str(),
+			block.data);
+			
+		stats.write += AddElapsed(stageStart);
+		
+		{
+			scoped_lock lock(pipelineMutex);
+			
+			if (written) writtenCount = i + 1;
+			else failed = true;
+			
+			windowBytes -= tasks[i].blockSize;
+		}
+		windowCondition.notify_all();
+		
+		if (!written) break;
+	}
+	
+	for (auto& w : workers) w.join();
+	
+	if (failed
+		|| !stream.Finish())
+	{
+		return false;
+	}
+	
+	//
+	// REPORT STAGE UTILIZATION
+	//
+	
+	f64 wallMs = duration<f64, milli>(steady_clock::now() - pipelineStart).count();
+	f64 workerMs = max(wallMs * threadCount, 1.0);
+	f64 writerMs = max(wallMs, 1.0);
+	
+	auto percent = [](f64 busy, f64 total)
+		{
+			return to_string(scast<u32>(busy / total * 100.0)) + "%";
+		};
+		
+	Log::Print(
+		"Converted '" + to_string(tasks.size()) + "' models from '" + sourceName + "' in '" + to_string(scast<u32>(wallMs)) + "' ms with '" + to_string(threadCount) + "' workers, stage utilization:"
+		+ " convert " + percent(stats.convert, workerMs)
+		+ ", tangents " + percent(stats.tangents, workerMs)
+		+ ", serialize " + percent(stats.serialize, workerMs)
+		+ ", write " + percent(stats.write, writerMs),
+		"PARSE",
+		LogType::LOG_INFO);
+		
+	if (options.isStreamed)
+	{
+		Log::Print(
+			"Streamed '" + to_string(tasks.size()) + "' models from '" + sourceName + "' with peak memory of '" + to_string(GetPeakMemoryBytes() / (1024 * 1024)) + "' MB.",
+			"PARSE",
+			LogType::LOG_INFO);
+	}
+	
+	return true;
+}
+
+f64 AddElapsed(steady_clock::time_point& stageStart)
+{
+	auto now = steady_clock::now();
+	f64 elapsed = duration<f64, milli>(now - stageStart).count();
+	
+	stageStart = now;
+	
+	return elapsed;
+}
+
+bool GetSceneNodes(
+	const aiScene* scene,
+	const string& sourceName,
+	vector<Node>& outNodes)
+{
+	if (!scene
+		|| !scene->mRootNode
+		|| scene->mNumMeshes == 0)
+	{
+		PrintError("Failed to load model because input path '" + sourceName + "' points to a broken or empty model file!");
+		
+		return false;
+	}
+	
+	GetAllNodes(scene, scene->mRootNode, outNodes);
+	
+	if (outNodes.empty())
+	{
+		PrintError("Failed to load model because input path '" + sourceName + "' has no nodes!");
+		
+		return false;
+	}
+	
+	return true;
+}
+
+void BuildModelBlock(
+	const Node& n,
+	const Mesh& m,
+	ModelBlock& b)
+{
+	aiMesh* mesh = m.mesh;
+	
+	//get full transform per node
+	
+	aiMatrix4x4 fullTransform = n.node->mTransformation;
+	aiNode* parent = n.node->mParent;
+	
+	while (parent)
+	{
+		fullTransform = parent->mTransformation * fullTransform;
+		parent = parent->mParent;
+	}
+	
+	aiVector3D scaling{};
+	aiQuaternion rotation{};
+	aiVector3D position{};
+	
+	fullTransform.Decompose(scaling, rotation, position);
+	
+	//get vertices and indices
+	
+	StringToCharArray(n.nodeName, b.nodeName);
+	StringToCharArray(m.meshName, b.meshName);
+	StringToCharArray(n.nodePath, b.nodePath);
+	
+	ZeroPadCharArray(b.nodeName);
+	ZeroPadCharArray(b.meshName);
+	ZeroPadCharArray(b.nodePath);
+	
+	b.position[0] = position.x;
+	b.position[1] = position.y;
+	b.position[2] = position.z;
+	
+	b.rotation[0] = rotation.w;
+	b.rotation[1] = rotation.x;
+	b.rotation[2] = rotation.y;
+	b.rotation[3] = rotation.z;
+	
+	b.size[0] = scaling.x;
+	b.size[1] = scaling.y;
+	b.size[2] = scaling.z;
+
+	//vertices
+	b.vertices.reserve(mesh->mNumVertices);
+	for (u32 i = 0; i < mesh->mNumVertices; i++)
+	{
+		Vertex v{};
+		
+		v.position[0] = mesh->mVertices[i].x * SCALE_MULTIPLIER;
+		v.position[1] = mesh->mVertices[i].y * SCALE_MULTIPLIER;
+		v.position[2] = mesh->mVertices[i].z * SCALE_MULTIPLIER;
+		
+		if (mesh->HasNormals())
+		{
+			vec3 norm =
+			{
+				mesh->mNormals[i].x,
+				mesh->mNormals[i].y,
+				mesh->mNormals[i].z
+			};
+			norm = normalize(norm);
+			
+			v.normal[0] = norm.x;
+			v.normal[1] = norm.y;
+			v.normal[2] = norm.z;
+		}
+		
+		if (mesh->HasTextureCoords(0))
+		{
+			v.texCoord[0] = mesh->mTextureCoords[0][i].x;
+			v.texCoord[1] = mesh->mTextureCoords[0][i].y;
+		}
+		
+		b.vertices.push_back(v);
+	}
+	b.verticesSize = b.vertices.size() * sizeof(Vertex);
+	
+	//indices
+	b.indices.reserve(mesh->mNumFaces * 3);
+	for (u32 f = 0; f < mesh->mNumFaces; f++)
+	{
+		const aiFace& face = mesh->mFaces[f];
+		for (u32 j = 0; j < face.mNumIndices; j++)
+		{
+			b.indices.push_back(face.mIndices[j]);
+		}
+	}
+	b.indicesSize = b.indices.size() * sizeof(u32);
+}
+
+void GenerateTangents(ModelBlock& b)
+{
+	vector<vec3> tan1(b.vertices.size(), vec3(0));
+	vector<vec3> tan2(b.vertices.size(), vec3(0));
+	
+	//accumulate tangents/bitangents
+	for (size_t i = 0; i < b.indices.size(); i += 3)
+	{
+		u32 i1 = b.indices[i + 0];
+		u32 i2 = b.indices[i + 1];
+		u32 i3 = b.indices[i + 2];
+		
+		Vertex& v1 = b.vertices[i1];
+		Vertex& v2 = b.vertices[i2];
+		Vertex& v3 = b.vertices[i3];
+		
+		vec3 p1 = v1.position;
+		vec3 p2 = v2.position;
+		vec3 p3 = v3.position;
+		
+		vec2 w1 = v1.texCoord;
+		vec2 w2 = v2.texCoord;
+		vec2 w3 = v3.texCoord;
+		
+		f32 x1 = p2.x - p1.x;
+		f32 x2 = p3.x - p1.x;
+		f32 y1 = p2.y - p1.y;
+		f32 y2 = p3.y - p1.y;
+		f32 z1 = p2.z - p1.z;
+		f32 z2 = p3.z - p1.z;
+
+		f32 s1 = w2.x - w1.x;
+		f32 s2 = w3.x - w1.x;
+		f32 t1 = w2.y - w1.y;
+		f32 t2 = w3.y - w1.y;
+		
+		f32 r = (s1 * t2 - s2 * t1);
+		if (fabs(r) < 1e-6f) r = 1.0f;
+		else r = 1.0f / r;
+		
+		vec3 sdir(
+			(t2 * x1 - t1 * x2) * r,
+			(t2 * y1 - t1 * y2) * r,
+			(t2 * z1 - t1 * z2) * r);
+
+		vec3 tdir(
+			(s1 * x2 - s2 * x1) * r,
+			(s1 * y2 - s2 * y1) * r,
+			(s1 * z2 - s2 * z1) * r);
+
+		tan1[i1] += sdir;
+		tan1[i2] += sdir;
+		tan1[i3] += sdir;
+
+		tan2[i1] += tdir;
+		tan2[i2] += tdir;
+		tan2[i3] += tdir;
+	}
+
+	//orthogonalize and store handedness
+	for (size_t i = 0; i < b.vertices.size(); i++)
+	{
+		vec3 n = normalize(vec3(b.vertices[i].normal));
+		vec3 t = tan1[i];
+		
+		//gram-schmidt orthogonalize
+		vec3 tangent = t - n * dot(n, t);
+		
+		if (length(tangent) < 1e-6) tangent = vec3(1, 0, 0);
+		else tangent = normalize(tangent);
+		
+		//calculate handedness
+		float w = (dot(cross(n, tangent), tan2[i]) < 0.0f)
+			? 1.0f
+			: 0.0f;
+			
+		b.vertices[i].tangent[0] = tangent.x;
+		b.vertices[i].tangent[1] = tangent.y;
+		b.vertices[i].tangent[2] = tangent.z;
+		b.vertices[i].tangent[3] = w;
+	}
+}
+
+void PrintModelInfo(const ModelBlock& m)
+{
+	ostringstream oss{};
+	
+	oss << "Model info for '" << m.nodeName << "'\n"
+		<< "  mesh name:     " << m.meshName << "\n"
+		<< "  node path:     " << m.nodePath << "\n"
+		<< "  dataTypeFlags: " << m.dataTypeFlags << "\n"
+		<< "  renderType:    " << m.renderType << "\n\n"
+		
+		<< "  position: " << m.position[0] << ", " << m.position[1] << ", " << m.position[2] << "\n" 
+		<< "  rotation: " << m.rotation[0] << ", " << m.rotation[1] << ", " << m.rotation[2] << ", " << m.rotation[3] << "\n" 
+		<< "  size:     " << m.size[0] << ", " << m.size[1] << ", " << m.size[2] << "\n\n" 
+		
+		<< "  vertices offset: " << m.verticesOffset << "\n"
+		<< "  vertices size:   " << m.verticesSize << "\n"
+		<< "  indices offset:  " << m.indicesOffset << "\n"
+		<< "  indices size:    " << m.indicesSize << "\n"
+		<< "  vertices count:  " << m.vertices.size() << "\n"
+		<< "  indices count:   " << m.indices.size() << "\n\n"
+		
+		<< "--------------------\n\n";
+		
+	Log::Print(oss.str());
+}
+
+void ReleaseMeshData(aiMesh* mesh)
+{
+	delete[] mesh->mVertices;
+	delete[] mesh->mNormals;
+	delete[] mesh->mTangents;
+	delete[] mesh->mBitangents;
+	delete[] mesh->mFaces;
+	
+	mesh->mVertices = nullptr;
+	mesh->mNormals = nullptr;
+	mesh->mTangents = nullptr;
+	mesh->mBitangents = nullptr;
+	mesh->mFaces = nullptr;
+	
+	for (u32 i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; i++)
+	{
+		delete[] mesh->mColors[i];
+		mesh->mColors[i] = nullptr;
+	}
+	for (u32 i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; i++)
+	{
+		delete[] mesh->mTextureCoords[i];
+		mesh->mTextureCoords[i] = nullptr;
+	}
+	
+	mesh->mNumVertices = 0;
+	mesh->mNumFaces = 0;
+}
+
+size_t GetPeakMemoryBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	
+	if (!GetProcessMemoryInfo(
+		GetCurrentProcess(),
+		&counters,
+		sizeof(counters)))
+	{
+		return 0;
+	}
+	
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	
+	//linux reports kilobytes
+	return scast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void GetAllNodes(
+	const aiScene* scene,
+	aiNode* node,
+	vector<Node>& out)
+{
+	//store all found meshes and their hierarchy paths
+	if (node->mNumMeshes > 0)
+	{
+		Node n{};
+	
+		string nodePath = node->mName.C_Str();
+		aiNode* parent = node->mParent;
+	
+		while (parent)
+		{
+			nodePath = string(parent->mName.C_Str()) + "/" + nodePath;
+			parent = parent->mParent;
+		}
+			
+		string nodeName = node->mName.C_Str();
+		string suffix = "/" + nodeName;
+				
+		//strip trailing node name from path
+		if (nodePath == nodeName) nodePath.clear();
+		else if (nodePath.size() > suffix.size()
+			&& nodePath.rfind(suffix) == nodePath.size() - suffix.size())
+		{
+			nodePath.erase(nodePath.size() - suffix.size(), suffix.size());	
+		}
+			
+		for (u32 i = 0; i < node->mNumMeshes; i++)
+		{
+			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+			
+			string meshName = mesh->mName.length > 0
+				? mesh->mName.C_Str()
+				: nodeName + "_mesh" + to_string(i);
+				
+			n.meshes.push_back(
+			{
+				.mesh = mesh,
+				.meshName = meshName
+			});
+		}
+				
+		n.node = node;
+		n.nodeName = nodeName;
+		n.nodePath = nodePath;
+			
+		out.push_back(n);
+	}
+			
+	//recurse into children
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		GetAllNodes(scene, node->mChildren[i], out);
+	}
+};
\ No newline at end of file
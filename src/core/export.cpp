@@ -0,0 +1,650 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <limits>
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/file_utils.hpp"
+#include "KalaHeaders/import_kmd.hpp"
+
+#include "export.hpp"
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaFile::WriteU8;
+using KalaHeaders::KalaFile::WriteU16;
+using KalaHeaders::KalaFile::WriteU32;
+using KalaHeaders::KalaFile::WriteU64;
+using KalaHeaders::KalaFile::WriteFixedString;
+using KalaHeaders::KalaModelData::ModelHeader;
+using KalaHeaders::KalaModelData::Vertex;
+using KalaHeaders::KalaModelData::KMD_VERSION;
+using KalaHeaders::KalaModelData::KMD_VERSION_2;
+using KalaHeaders::KalaModelData::CORRECT_MODEL_HEADER_SIZE;
+using KalaHeaders::KalaModelData::CORRECT_MODEL_TABLE_SIZE;
+using KalaHeaders::KalaModelData::VERTICE_DATA_OFFSET;
+using KalaHeaders::KalaModelData::MAX_MODEL_COUNT;
+using KalaHeaders::KalaModelData::MAX_MODEL_TABLE_SIZE;
+using KalaHeaders::KalaModelData::MAX_MODEL_BLOCK_SIZE;
+using KalaHeaders::KalaModelData::MAX_SINGLE_BLOCK_SIZE;
+using KalaHeaders::KalaModelData::GetHeaderSize;
+using KalaHeaders::KalaModelData::GetTableSize;
+using KalaHeaders::KalaModelData::MODEL_BLOCK_ALIGNMENT;
+using KalaHeaders::KalaModelData::BuildNameIndex;
+using KalaHeaders::KalaModelData::BuildChecksumSection;
+using KalaHeaders::KalaModelData::ComputeCRC32C;
+
+using std::string;
+using std::vector;
+using std::ofstream;
+using std::ios;
+using std::to_string;
+using std::bit_cast;
+using std::numeric_limits;
+using std::error_code;
+using std::filesystem::path;
+using std::filesystem::rename;
+using std::filesystem::remove;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f32 = float;
+
+static void WriteModelBlock(
+	vector<u8>& output,
+	size_t& offset,
+	const ModelBlock& m);
+	
+//Returns the zero bytes needed before the first model block so that
+//every block starts at a multiple of MODEL_BLOCK_ALIGNMENT in the file
+static u32 GetBlockPadding(size_t blockRegionStart)
+{
+	return (MODEL_BLOCK_ALIGNMENT - blockRegionStart % MODEL_BLOCK_ALIGNMENT) % MODEL_BLOCK_ALIGNMENT;
+}
+
+static u64 GetBlockSize(const ModelBlock& b)
+{
+	return VERTICE_DATA_OFFSET + u64(b.verticesSize) + b.indicesSize;
+}
+
+//Returns version 1 if modelCount models with blocksSize bytes of model blocks fit its limits
+//so the file stays readable by older importers, larger files are written as version 2
+static u8 GetExportVersion(
+	u64 modelCount,
+	u64 blocksSize)
+{
+	u64 padding = GetBlockPadding(CORRECT_MODEL_HEADER_SIZE + CORRECT_MODEL_TABLE_SIZE * modelCount);
+	
+	return modelCount <= MAX_MODEL_COUNT
+		&& CORRECT_MODEL_TABLE_SIZE * modelCount <= MAX_MODEL_TABLE_SIZE
+		&& blocksSize + padding <= MAX_MODEL_BLOCK_SIZE
+		? KMD_VERSION
+		: KMD_VERSION_2;
+}
+
+//Writes the top header of a file of this version to the start of output
+static void WriteHeader(
+	vector<u8>& output,
+	u8 version,
+	u8 scaleFactor,
+	u32 modelCount,
+	u64 tablesSize,
+	u64 blocksSize)
+{
+	ModelHeader modelHeader{};
+	
+	size_t offset{};
+	
+	WriteU32(output, offset, modelHeader.magic); offset += 4;
+	WriteU8(output, offset, version);            offset++;
+	WriteU8(output, offset, scaleFactor);        offset++;
+	WriteU32(output, offset, modelCount);        offset += 4;
+	
+	if (version == KMD_VERSION_2)
+	{
+		WriteU64(output, offset, tablesSize); offset += 8;
+		WriteU64(output, offset, blocksSize); offset += 8;
+	}
+	else
+	{
+		WriteU32(output, offset, scast<u32>(tablesSize)); offset += 4;
+		WriteU32(output, offset, scast<u32>(blocksSize)); offset += 4;
+	}
+}
+
+//Writes the model table at tableOffset of the model tables of a file of this version
+static void WriteModelTable(
+	vector<u8>& modelTable,
+	size_t tableOffset,
+	u8 version,
+	const char* nodeName,
+	u64 blockOffset,
+	u32 blockSize)
+{
+	WriteFixedString(
+		modelTable,
+		tableOffset,
+		nodeName,
+		20);
+		
+	if (version == KMD_VERSION_2)
+	{
+		WriteU64(modelTable, tableOffset + 20, blockOffset);
+		WriteU64(modelTable, tableOffset + 28, blockSize);
+	}
+	else
+	{
+		WriteU32(modelTable, tableOffset + 20, scast<u32>(blockOffset));
+		WriteU32(modelTable, tableOffset + 24, blockSize);
+	}
+}
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"EXPORT_MODEL",
+		LogType::LOG_ERROR,
+		2);
+}
+
+//Returns the path next to targetPath that exports are written to before they replace it
+static path GetTempPath(const path& targetPath)
+{
+	path tempPath = targetPath;
+	tempPath += ".tmp";
+	
+	return tempPath;
+}
+
+//Renames the finished temporary file over the target, the temporary file is deleted if that fails
+static bool ReplaceTarget(
+	const path& tempPath,
+	const path& targetPath)
+{
+	error_code ec{};
+	rename(tempPath, targetPath, ec);
+	
+	if (ec)
+	{
+		remove(tempPath, ec);
+		
+		PrintError("Failed to export because the finished file could not replace path '" + targetPath.string() + "'!");
+		return false;
+	}
+	
+	return true;
+}
+
+namespace KalaModel
+{
+	bool Export::BuildKMF(
+		u8 scaleFactor,
+		const vector<ModelBlock>& modelBlocks,
+		vector<u8>& output)
+	{
+		if (modelBlocks.size() > numeric_limits<u32>::max())
+		{
+			PrintError("Failed to export because model count exceeded max allowed count '" + to_string(numeric_limits<u32>::max()) + "'!");
+			return false;
+		}
+		
+		u64 blocksSize{};
+		for (const auto& b : modelBlocks)
+		{
+			if (GetBlockSize(b) > MAX_SINGLE_BLOCK_SIZE)
+			{
+				PrintError("Failed to export because model '" + string(b.nodeName) + "' exceeded max allowed block size '" + to_string(MAX_SINGLE_BLOCK_SIZE) + "'!");
+				return false;
+			}
+			
+			blocksSize += GetBlockSize(b);
+		}
+		
+		//files past the version 1 limits are written as version 2
+		u8 version = GetExportVersion(modelBlocks.size(), blocksSize);
+		
+		size_t headerSize = GetHeaderSize(version);
+		size_t tableSize = GetTableSize(version);
+		
+		output.clear();
+		
+		vector<u8> modelTableOutput{};
+		vector<u8> modelBlockOutput{};
+		
+		//
+		// FIRST STORE THE MODEL TABLES
+		//
+		
+		size_t totalMTBytes = tableSize * modelBlocks.size();
+		modelTableOutput.reserve(totalMTBytes);
+		
+		u32 padding = GetBlockPadding(headerSize + totalMTBytes);
+		
+		u64 baseOffset = headerSize + totalMTBytes + padding;
+		size_t tableOffset{};
+		
+		for (const auto& b : modelBlocks)
+		{
+			u32 blockSize = scast<u32>(GetBlockSize(b));
+			
+			WriteModelTable(
+				modelTableOutput,
+				tableOffset,
+				version,
+				b.nodeName,
+				baseOffset,
+				blockSize);
+			
+			//next table entry (internal buffer)
+			tableOffset += tableSize;
+			
+			//next model block (absolute in final file)
+			baseOffset += blockSize;
+		}
+		
+		//
+		// THEN STORE THE MODEL BLOCKS
+		//
+		
+		size_t totalMBBytes = padding + blocksSize;
+		
+		modelBlockOutput.reserve(totalMBBytes);
+		modelBlockOutput.assign(padding, 0);
+		
+		size_t mOffset = padding;
+		
+		for (const auto& m : modelBlocks) WriteModelBlock(modelBlockOutput, mOffset, m);
+		
+		vector<u32> checksums{};
+		checksums.reserve(modelBlocks.size());
+		
+		size_t blockStart = padding;
+		for (const auto& b : modelBlocks)
+		{
+			size_t blockSize = GetBlockSize(b);
+			
+			checksums.push_back(ComputeCRC32C(modelBlockOutput.data() + blockStart, blockSize));
+			blockStart += blockSize;
+		}
+
+		//
+		// AND PASS THE FINAL DATA
+		//
+		
+		WriteHeader(
+			output,
+			version,
+			scaleFactor,
+			scast<u32>(modelBlocks.size()),
+			totalMTBytes,
+			totalMBBytes);
+		
+		vector<u8> nameIndexOutput{};
+		BuildNameIndex(
+			modelTableOutput.data(),
+			scast<u32>(modelBlocks.size()),
+			nameIndexOutput,
+			version);
+			
+		vector<u8> checksumOutput{};
+		BuildChecksumSection(
+			checksums,
+			checksumOutput);
+		
+		output.reserve(headerSize + totalMTBytes + totalMBBytes + nameIndexOutput.size() + checksumOutput.size());
+		
+		output.insert(output.end(), modelTableOutput.begin(), modelTableOutput.end());
+		output.insert(output.end(), modelBlockOutput.begin(), modelBlockOutput.end());
+		output.insert(output.end(), nameIndexOutput.begin(), nameIndexOutput.end());
+		output.insert(output.end(), checksumOutput.begin(), checksumOutput.end());
+
+		return true;
+	}
+	
+	bool Export::ExportKMF(
+		const path& targetPath,
+		u8 scaleFactor,
+		vector<ModelBlock>& modelBlocks)
+	{
+		Log::Print(
+			"Starting to export models to path '" + targetPath.string() + "'.",
+			"EXPORT_MODEL",
+			LogType::LOG_DEBUG);
+			
+		vector<u8> output{};
+		
+		if (!BuildKMF(
+			scaleFactor,
+			modelBlocks,
+			output))
+		{
+			return false;
+		}
+			
+		path tempPath = GetTempPath(targetPath);
+		
+		ofstream file(
+			tempPath,
+			ios::binary
+			| ios::trunc);
+			
+		file.write(
+			reinterpret_cast<const char*>(output.data()), output.size());
+			
+		file.close();
+		
+		if (file.fail())
+		{
+			error_code ec{};
+			remove(tempPath, ec);
+			
+			Log::Print(
+				"Failed to export because writing to path '" + targetPath.string() + "' failed!",
+				"EXPORT_MODEL",
+				LogType::LOG_ERROR,
+				2);
+		
+			return false;
+		}
+		
+		if (!ReplaceTarget(tempPath, targetPath)) return false;
+			
+		Log::Print(
+			"Finished exporting models!",
+			"EXPORT_MODEL",
+			LogType::LOG_SUCCESS);
+			
+		return true;
+	}
+	
+	ExportStream::~ExportStream()
+	{
+		if (file.is_open()) Discard();
+	}
+	
+	void ExportStream::Discard()
+	{
+		if (file.is_open()) file.close();
+		
+		error_code ec{};
+		remove(tempPath, ec);
+	}
+	
+	bool ExportStream::Open(
+		const path& newTargetPath,
+		u8 newScaleFactor,
+		u32 newModelCount,
+		u64 expectedBlocksSize)
+	{
+		//a stream that is opened again drops the file it had not finished yet
+		if (file.is_open()) Discard();
+		
+		targetPath = newTargetPath;
+		tempPath = GetTempPath(targetPath);
+		scaleFactor = newScaleFactor;
+		modelCount = newModelCount;
+		writtenCount = 0;
+		
+		//the table size depends on the version, so it has to be picked before any block is written
+		version = GetExportVersion(modelCount, expectedBlocksSize);
+		
+		size_t headerSize = GetHeaderSize(version);
+		size_t tableSize = GetTableSize(version);
+		
+		//the padding is counted as part of the model blocks size
+		blocksSize = GetBlockPadding(headerSize + tableSize * modelCount);
+		
+		modelTable.assign(tableSize * modelCount, 0);
+		
+		checksums.clear();
+		checksums.reserve(modelCount);
+
+		Log::Print(
+			"Starting to stream models to path '" + targetPath.string() + "'.",
+			"EXPORT_MODEL",
+			LogType::LOG_DEBUG);
+			
+		file.clear();
+		file.open(
+			tempPath,
+			ios::binary
+			| ios::trunc);
+			
+		//header and model table are patched in Finish once all block sizes are known
+		vector<u8> reserved(headerSize + modelTable.size() + blocksSize, 0);
+		
+		file.write(
+			reinterpret_cast<const char*>(reserved.data()), reserved.size());
+			
+		if (file.fail())
+		{
+			Discard();
+			
+			PrintError("Failed to export because writing to path '" + targetPath.string() + "' failed!");
+			return false;
+		}
+		
+		return true;
+	}
+	
+	void ExportStream::SerializeBlock(
+		const ModelBlock& block,
+		vector<u8>& outBlockData)
+	{
+		outBlockData.clear();
+		outBlockData.reserve(VERTICE_DATA_OFFSET + u64(block.verticesSize) + block.indicesSize);
+		
+		size_t offset{};
+		WriteModelBlock(outBlockData, offset, block);
+	}
+	
+	bool ExportStream::WriteBlock(const ModelBlock& block)
+	{
+		//reuses the same buffer for every block so its capacity only grows to the largest block
+		SerializeBlock(block, blockBuffer);
+		
+		return WriteBlockData(
+			block.nodeName,
+			blockBuffer);
+	}
+	
+	bool ExportStream::WriteBlockData(
+		const char* nodeName,
+		const vector<u8>& blockData)
+	{
+		if (writtenCount == modelCount)
+		{
+			PrintError("Failed to export because more than '" + to_string(modelCount) + "' models were streamed to path '" + targetPath.string() + "'!");
+			return false;
+		}
+		
+		if (blockData.size() > MAX_SINGLE_BLOCK_SIZE)
+		{
+			PrintError("Failed to export because model '" + string(nodeName) + "' exceeded max allowed block size '" + to_string(MAX_SINGLE_BLOCK_SIZE) + "'!");
+			return false;
+		}
+		
+		if (version == KMD_VERSION
+			&& blocksSize + blockData.size() > MAX_MODEL_BLOCK_SIZE)
+		{
+			PrintError("Failed to export because model data size exceeded max allowed size '" + to_string(MAX_MODEL_BLOCK_SIZE) + "' of version 1 files, pass the expected blocks size to ExportStream::Open to write version 2!");
+			return false;
+		}
+		
+		u32 blockSize = scast<u32>(blockData.size());
+		u64 blockOffset = GetHeaderSize(version) + modelTable.size() + blocksSize;
+		size_t tableOffset = GetTableSize(version) * writtenCount;
+		
+		WriteModelTable(
+			modelTable,
+			tableOffset,
+			version,
+			nodeName,
+			blockOffset,
+			blockSize);
+		
+		file.write(
+			reinterpret_cast<const char*>(blockData.data()), blockData.size());
+			
+		if (file.fail())
+		{
+			PrintError("Failed to export because writing to path '" + targetPath.string() + "' failed!");
+			return false;
+		}
+		
+		checksums.push_back(ComputeCRC32C(blockData.data(), blockData.size()));
+		
+		blocksSize += blockSize;
+		writtenCount++;
+
+		return true;
+	}
+	
+	bool ExportStream::Finish()
+	{
+		if (writtenCount != modelCount)
+		{
+			Discard();
+			
+			PrintError("Failed to export because only '" + to_string(writtenCount) + "' of '" + to_string(modelCount) + "' models were streamed to path '" + targetPath.string() + "'!");
+			return false;
+		}
+		
+		vector<u8> header{};
+		header.reserve(GetHeaderSize(version) + modelTable.size());
+		
+		WriteHeader(
+			header,
+			version,
+			scaleFactor,
+			modelCount,
+			modelTable.size(),
+			blocksSize);
+		
+		header.insert(header.end(), modelTable.begin(), modelTable.end());
+		
+		//the name index goes after the last block, before the header is patched
+		vector<u8> nameIndex{};
+		BuildNameIndex(
+			modelTable.data(),
+			modelCount,
+			nameIndex,
+			version);
+		
+		file.write(
+			reinterpret_cast<const char*>(nameIndex.data()), nameIndex.size());
+			
+		vector<u8> checksumSection{};
+		BuildChecksumSection(
+			checksums,
+			checksumSection);
+			
+		file.write(
+			reinterpret_cast<const char*>(checksumSection.data()), checksumSection.size());
+		
+		file.seekp(0);
+		file.write(
+			reinterpret_cast<const char*>(header.data()), header.size());
+			
+		file.close();
+		
+		vector<u8>().swap(blockBuffer);
+		
+		if (file.fail())
+		{
+			Discard();
+			
+			PrintError("Failed to export because writing to path '" + targetPath.string() + "' failed!");
+			return false;
+		}
+		
+		if (!ReplaceTarget(tempPath, targetPath)) return false;
+		
+		Log::Print(
+			"Finished streaming models!",
+			"EXPORT_MODEL",
+			LogType::LOG_SUCCESS);
+			
+		return true;
+	}
+}
+
+static void WriteModelBlock(
+	vector<u8>& output,
+	size_t& offset,
+	const ModelBlock& m)
+{
+	WriteFixedString(
+		output,
+		offset,
+		m.nodeName,
+		sizeof(m.nodeName));
+	offset += 20;
+	
+	WriteFixedString(
+		output,
+		offset,
+		m.meshName,
+		sizeof(m.meshName));
+	offset += 20;
+	
+	WriteFixedString(
+		output,
+		offset,
+		m.nodePath,
+		sizeof(m.nodePath));
+	offset += 50;
+		
+	WriteU8(output, offset, m.dataTypeFlags); offset++;
+	WriteU8(output, offset, m.renderType);    offset++;
+	
+	WriteU32(output, offset, bit_cast<u32>(m.position[0])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.position[1])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.position[2])); offset += 4;
+	
+	WriteU32(output, offset, bit_cast<u32>(m.rotation[0])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.rotation[1])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.rotation[2])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.rotation[3])); offset += 4;
+	
+	WriteU32(output, offset, bit_cast<u32>(m.size[0])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.size[1])); offset += 4;
+	WriteU32(output, offset, bit_cast<u32>(m.size[2])); offset += 4;
+	
+	WriteU32(output, offset, m.verticesOffset); offset += 4;
+	WriteU32(output, offset, m.verticesSize);   offset += 4;
+	WriteU32(output, offset, m.indicesOffset);  offset += 4;
+	WriteU32(output, offset, m.indicesSize);    offset += 4;
+	
+	for (const auto& v : m.vertices)
+	{
+		WriteU32(output, offset, bit_cast<u32>(v.position[0])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.position[1])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.position[2])); offset += 4;
+		
+		WriteU32(output, offset, bit_cast<u32>(v.normal[0])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.normal[1])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.normal[2])); offset += 4;
+		
+		WriteU32(output, offset, bit_cast<u32>(v.texCoord[0])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.texCoord[1])); offset += 4;
+		
+		WriteU32(output, offset, bit_cast<u32>(v.tangent[0])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.tangent[1])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.tangent[2])); offset += 4;
+		WriteU32(output, offset, bit_cast<u32>(v.tangent[3])); offset += 4;
+	}
+	
+	for (u32 index : m.indices)
+	{
+		WriteU32(output, offset, index);
+		offset += 4;
+	}
+}
\ No newline at end of file
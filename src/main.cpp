@@ -9,12 +9,20 @@
 #include "KalaCLI/include/command.hpp"
 
 #include "parse.hpp"
+#include "watch.hpp"
+#include "serve.hpp"
+#include "shard.hpp"
+#include "audit.hpp"
 
 using KalaCLI::Core;
 using KalaCLI::Command;
 using KalaCLI::CommandManager;
 
 using KalaModel::Parse;
+using KalaModel::Watch;
+using KalaModel::Serve;
+using KalaModel::Shard;
+using KalaModel::Audit;
 
 using std::ostringstream;
 
@@ -34,6 +42,68 @@ static void AddExternalCommands()
 		<< "    Third parameter must be origin model path (.gltf, .obj or .fbx)\n"
 		<< "    Fourth parameter must be target path (.kmd)";
 	
+	ostringstream msgStreamParse{};
+	
+	msgStreamParse << "Compiles models to kmd one model at a time to keep memory use bounded for very large scenes.\n"
+		<< "    Second parameter must be downscale size\n"
+		<< "    Third parameter must be origin model path (.gltf, .obj or .fbx)\n"
+		<< "    Fourth parameter must be target path (.kmd)";
+	
+	ostringstream msgWatch{};
+	
+	msgWatch << "Keeps running and recompiles models to kmd whenever they are saved.\n"
+		<< "    Second parameter must be downscale size\n"
+		<< "    Third parameter must be origin folder with .gltf, .obj or .fbx models\n"
+		<< "    Fourth parameter must be target folder for .kmd files";
+	
+	ostringstream msgServe{};
+	
+	msgServe << "Keeps running as a local conversion server on a unix domain socket.\n"
+		<< "    Second parameter must be the socket path";
+	
+	ostringstream msgSendPath{};
+	
+	msgSendPath << "Asks a running conversion server to compile a model from path to path.\n"
+		<< "    Second parameter must be downscale size\n"
+		<< "    Third parameter must be the server socket path\n"
+		<< "    Fourth parameter must be origin model path (.gltf, .obj or .fbx)\n"
+		<< "    Fifth parameter must be target path (.kmd)";
+	
+	ostringstream msgSendBytes{};
+	
+	msgSendBytes << "Uploads a model to a running conversion server and receives the kmd through shared memory.\n"
+		<< "    Second parameter must be downscale size\n"
+		<< "    Third parameter must be the server socket path\n"
+		<< "    Fourth parameter must be origin model path (.gltf, .obj or .fbx)\n"
+		<< "    Fifth parameter must be target path (.kmd)";
+	
+	ostringstream msgShard{};
+	
+	msgShard << "Compiles every model of a manifest to kmd with several worker processes.\n"
+		<< "    Second parameter must be the manifest path, each line is 'downscale size<TAB>origin path<TAB>target path'\n"
+		<< "    Third parameter must be a new or empty job folder shared by all workers\n"
+		<< "    Fourth parameter must be the count of worker processes";
+	
+	ostringstream msgShardWorker{};
+	
+	msgShardWorker << "Compiles jobs from a shard job folder until it is empty, can run on any machine that shares the folder.\n"
+		<< "    Second parameter must be the job folder";
+	
+	ostringstream msgVerify{};
+	
+	msgVerify << "Fully validates kmd files in parallel and reports the throughput.\n"
+		<< "    Second parameter must be a kmd file or a folder that is searched for kmd files";
+	
+	ostringstream msgInspect{};
+	
+	msgInspect << "Prints the header, tables and block summaries of a kmd file without reading its blocks.\n"
+		<< "    Second parameter must be the kmd file";
+	
+	ostringstream msgInspectJSON{};
+	
+	msgInspectJSON << "Prints the header, tables and block summaries of a kmd file as JSON without reading its blocks.\n"
+		<< "    Second parameter must be the kmd file";
+	
 	Command cmd_parse
 	{
 		.primary = { "parse", "p" },
@@ -48,9 +118,92 @@ static void AddExternalCommands()
 		.paramCount = 4,
 		.targetFunction = Parse::Command_VerboseParse
 	};
+	Command cmd_streamparse
+	{
+		.primary = { "streamparse", "sp" },
+		.description = msgStreamParse.str(),
+		.paramCount = 4,
+		.targetFunction = Parse::Command_StreamParse
+	};
+
+	Command cmd_watch
+	{
+		.primary = { "watch", "w" },
+		.description = msgWatch.str(),
+		.paramCount = 4,
+		.targetFunction = Watch::Command_Watch
+	};
+
+	Command cmd_serve
+	{
+		.primary = { "serve" },
+		.description = msgServe.str(),
+		.paramCount = 2,
+		.targetFunction = Serve::Command_Serve
+	};
+	Command cmd_sendpath
+	{
+		.primary = { "sendpath" },
+		.description = msgSendPath.str(),
+		.paramCount = 5,
+		.targetFunction = Serve::Command_SendPath
+	};
+	Command cmd_sendbytes
+	{
+		.primary = { "sendbytes" },
+		.description = msgSendBytes.str(),
+		.paramCount = 5,
+		.targetFunction = Serve::Command_SendBytes
+	};
+	Command cmd_shard
+	{
+		.primary = { "shard" },
+		.description = msgShard.str(),
+		.paramCount = 4,
+		.targetFunction = Shard::Command_Shard
+	};
+	Command cmd_shardworker
+	{
+		.primary = { "shardworker" },
+		.description = msgShardWorker.str(),
+		.paramCount = 2,
+		.targetFunction = Shard::Command_ShardWorker
+	};
+
+	Command cmd_verify
+	{
+		.primary = { "verify" },
+		.description = msgVerify.str(),
+		.paramCount = 2,
+		.targetFunction = Audit::Command_Verify
+	};
+	Command cmd_inspect
+	{
+		.primary = { "inspect" },
+		.description = msgInspect.str(),
+		.paramCount = 2,
+		.targetFunction = Audit::Command_Inspect
+	};
+	Command cmd_inspectjson
+	{
+		.primary = { "inspectjson" },
+		.description = msgInspectJSON.str(),
+		.paramCount = 2,
+		.targetFunction = Audit::Command_InspectJSON
+	};
 
 	CommandManager::AddCommand(cmd_parse);
 	CommandManager::AddCommand(cmd_verboseparse);
+	CommandManager::AddCommand(cmd_streamparse);
+	CommandManager::AddCommand(cmd_watch);
+	CommandManager::AddCommand(cmd_serve);
+	CommandManager::AddCommand(cmd_sendpath);
+	CommandManager::AddCommand(cmd_sendbytes);
+	CommandManager::AddCommand(cmd_shard);
+	CommandManager::AddCommand(cmd_shardworker);
+	CommandManager::AddCommand(cmd_verify);
+	CommandManager::AddCommand(cmd_inspect);
+	CommandManager::AddCommand(cmd_inspectjson);
 }
 
 int main(int argc, char* argv[])
@@ -0,0 +1,891 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <climits>
+#include <iterator>
+#include <filesystem>
+#include <algorithm>
+#include <new>
+
+//The CLI is only built on Windows, so the AF_UNIX socket and shm_open paths have
+//never been built by CMake or run, they are only syntax checked against the glibc headers
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <afunix.h>
+	#include <Windows.h>
+#elif __linux__
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include "Assimp/include/Importer.hpp"
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/thread_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "serve.hpp"
+#include "convert.hpp"
+#include "workers.hpp"
+
+using Assimp::Importer;
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaThread::dthread;
+
+using KalaCLI::Core;
+
+using KalaModel::Serve;
+using KalaModel::ServeRequest;
+using KalaModel::ServeResponse;
+using KalaModel::ServeSource;
+using KalaModel::ServeResult;
+using KalaModel::Convert;
+using KalaModel::ConvertOptions;
+using KalaModel::Workers;
+using KalaModel::SERVE_MAGIC;
+using KalaModel::SERVE_REQUEST_HEADER_SIZE;
+using KalaModel::SERVE_RESPONSE_HEADER_SIZE;
+using KalaModel::MAX_SERVE_SOURCE_SIZE;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+using std::istreambuf_iterator;
+using std::promise;
+using std::future;
+using std::atomic;
+using std::memcpy;
+using std::clamp;
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::filesystem::path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::create_directories;
+using std::filesystem::remove;
+using std::filesystem::file_size;
+using std::thread;
+using std::error_code;
+using std::bad_alloc;
+
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Max count of conversion threads started by serve
+constexpr u32 MAX_SERVE_WORKERS = 8u;
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+constexpr socket_t INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+#else
+using socket_t = int;
+constexpr socket_t INVALID_SOCKET_HANDLE = -1;
+#endif
+
+//Shared memory segment that holds a compiled kmd until the connection that asked for it closes
+struct SharedSegment
+{
+	string name{};
+#ifdef _WIN32
+	HANDLE handle{};
+#endif
+};
+
+static atomic<u32> segmentCounter{};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"SERVE",
+		LogType::LOG_ERROR,
+		2);
+}
+
+//
+// SOCKETS
+//
+
+static bool InitSockets()
+{
+#ifdef _WIN32
+	WSADATA data{};
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+	return true;
+#endif
+}
+
+static void CloseSocket(socket_t s)
+{
+#ifdef _WIN32
+	closesocket(s);
+#else
+	close(s);
+#endif
+}
+
+static bool SendAll(
+	socket_t s,
+	const void* data,
+	size_t size)
+{
+	const char* p = scast<const char*>(data);
+	
+	while (size > 0)
+	{
+#ifdef _WIN32
+		int sent = send(s, p, scast<int>(clamp(size, size_t{ 1 }, size_t{ INT_MAX })), 0);
+#else
+		ssize_t sent = send(s, p, size, MSG_NOSIGNAL);
+#endif
+		if (sent <= 0) return false;
+		
+		p += sent;
+		size -= scast<size_t>(sent);
+	}
+	
+	return true;
+}
+
+static bool RecvAll(
+	socket_t s,
+	void* data,
+	size_t size)
+{
+	char* p = scast<char*>(data);
+	
+	while (size > 0)
+	{
+#ifdef _WIN32
+		int received = recv(s, p, scast<int>(clamp(size, size_t{ 1 }, size_t{ INT_MAX })), 0);
+#else
+		ssize_t received = recv(s, p, size, 0);
+#endif
+		if (received <= 0) return false;
+		
+		p += received;
+		size -= scast<size_t>(received);
+	}
+	
+	return true;
+}
+
+static bool MakeAddress(
+	const string& socketPath,
+	sockaddr_un& outAddress)
+{
+	outAddress = {};
+	outAddress.sun_family = AF_UNIX;
+	
+	if (socketPath.size() >= sizeof(outAddress.sun_path))
+	{
+		PrintError("Socket path '" + socketPath + "' is longer than the allowed '" + to_string(sizeof(outAddress.sun_path) - 1) + "' characters!");
+		
+		return false;
+	}
+	
+	memcpy(outAddress.sun_path, socketPath.data(), socketPath.size());
+	
+	return true;
+}
+
+//
+// SHARED MEMORY
+//
+
+static bool CreateSharedSegment(
+	const vector<u8>& data,
+	SharedSegment& outSegment)
+{
+	u32 id = segmentCounter.fetch_add(1);
+
+#ifdef _WIN32
+	outSegment.name = "Local\\kalamodel-" + to_string(GetCurrentProcessId()) + "-" + to_string(id);
+	
+	u64 size = data.size();
+	
+	outSegment.handle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE,
+		nullptr,
+		PAGE_READWRITE,
+		scast<DWORD>(size >> 32),
+		scast<DWORD>(size & 0xFFFFFFFF),
+		outSegment.name.c_str());
+		
+	if (!outSegment.handle) return false;
+	
+	void* view = MapViewOfFile(outSegment.handle, FILE_MAP_WRITE, 0, 0, data.size());
+	if (!view)
+	{
+		CloseHandle(outSegment.handle);
+		outSegment.handle = nullptr;
+		
+		return false;
+	}
+	
+	memcpy(view, data.data(), data.size());
+	UnmapViewOfFile(view);
+	
+	return true;
+#elif __linux__
+	outSegment.name = "/kalamodel-" + to_string(getpid()) + "-" + to_string(id);
+	
+	int fd = shm_open(outSegment.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) return false;
+	
+	if (ftruncate(fd, scast<off_t>(data.size())) != 0)
+	{
+		close(fd);
+		shm_unlink(outSegment.name.c_str());
+		
+		return false;
+	}
+	
+	void* view = mmap(nullptr, data.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	
+	if (view == MAP_FAILED)
+	{
+		shm_unlink(outSegment.name.c_str());
+		
+		return false;
+	}
+	
+	memcpy(view, data.data(), data.size());
+	munmap(view, data.size());
+	
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void ReleaseSharedSegment(SharedSegment& segment)
+{
+#ifdef _WIN32
+	if (segment.handle) CloseHandle(segment.handle);
+	segment.handle = nullptr;
+#elif __linux__
+	shm_unlink(segment.name.c_str());
+#endif
+}
+
+static bool ReadSharedSegment(
+	const string& name,
+	size_t size,
+	vector<u8>& outData)
+{
+#ifdef _WIN32
+	HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+	if (!handle) return false;
+	
+	void* view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, size);
+	if (!view)
+	{
+		CloseHandle(handle);
+		
+		return false;
+	}
+	
+	outData.assign(scast<const u8*>(view), scast<const u8*>(view) + size);
+	
+	UnmapViewOfFile(view);
+	CloseHandle(handle);
+	
+	return true;
+#elif __linux__
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) return false;
+	
+	void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	
+	if (view == MAP_FAILED) return false;
+	
+	outData.assign(scast<const u8*>(view), scast<const u8*>(view) + size);
+	munmap(view, size);
+	
+	return true;
+#else
+	return false;
+#endif
+}
+
+//
+// PROTOCOL
+//
+
+static bool SendRequest(
+	socket_t s,
+	const ServeRequest& request)
+{
+	u8 header[SERVE_REQUEST_HEADER_SIZE]{};
+	
+	u32 sourceSize = scast<u32>(request.source.size());
+	u16 hintSize = scast<u16>(request.extensionHint.size());
+	u16 targetSize = scast<u16>(request.target.size());
+	
+	memcpy(header + 0, &SERVE_MAGIC, sizeof(u32));
+	header[4] = scast<u8>(request.sourceType);
+	header[5] = scast<u8>(request.resultType);
+	header[6] = request.scaleFactor;
+	memcpy(header + 8, &sourceSize, sizeof(u32));
+	memcpy(header + 12, &hintSize, sizeof(u16));
+	memcpy(header + 14, &targetSize, sizeof(u16));
+	
+	return SendAll(s, header, sizeof(header))
+		&& SendAll(s, request.source.data(), sourceSize)
+		&& SendAll(s, request.extensionHint.data(), hintSize)
+		&& SendAll(s, request.target.data(), targetSize);
+}
+
+//Returns false if the connection closed or sent an invalid header,
+//outRejection is set if the request was valid but can't be served
+static bool ReceiveRequest(
+	socket_t s,
+	ServeRequest& outRequest,
+	string& outRejection)
+{
+	u8 header[SERVE_REQUEST_HEADER_SIZE]{};
+	if (!RecvAll(s, header, sizeof(header))) return false;
+	
+	u32 magic{};
+	u32 sourceSize{};
+	u16 hintSize{};
+	u16 targetSize{};
+	
+	memcpy(&magic, header + 0, sizeof(u32));
+	if (magic != SERVE_MAGIC
+		|| header[4] > scast<u8>(ServeSource::SOURCE_BYTES)
+		|| header[5] > scast<u8>(ServeResult::RESULT_SHARED_MEMORY))
+	{
+		return false;
+	}
+	
+	outRequest.sourceType = scast<ServeSource>(header[4]);
+	outRequest.resultType = scast<ServeResult>(header[5]);
+	outRequest.scaleFactor = clamp(header[6], u8{ 0 }, u8{ 8 });
+	
+	memcpy(&sourceSize, header + 8, sizeof(u32));
+	memcpy(&hintSize, header + 12, sizeof(u16));
+	memcpy(&targetSize, header + 14, sizeof(u16));
+	
+	if (sourceSize > MAX_SERVE_SOURCE_SIZE)
+	{
+		outRejection = "Request source size '" + to_string(sourceSize) + "' exceeds max allowed size '" + to_string(MAX_SERVE_SOURCE_SIZE) + "'!";
+		return false;
+	}
+	
+	try
+	{
+		outRequest.source.resize(sourceSize);
+		outRequest.extensionHint.resize(hintSize);
+		outRequest.target.resize(targetSize);
+	}
+	catch (const bad_alloc&)
+	{
+		outRejection = "Failed to allocate '" + to_string(sourceSize) + "' bytes for the request source!";
+		return false;
+	}
+	
+	return RecvAll(s, outRequest.source.data(), sourceSize)
+		&& RecvAll(s, outRequest.extensionHint.data(), hintSize)
+		&& RecvAll(s, outRequest.target.data(), targetSize);
+}
+
+static bool SendResponse(
+	socket_t s,
+	const ServeResponse& response)
+{
+	u8 header[SERVE_RESPONSE_HEADER_SIZE]{};
+	
+	u32 messageSize = scast<u32>(response.message.size());
+	
+	memcpy(header + 0, &SERVE_MAGIC, sizeof(u32));
+	header[4] = response.success ? 1 : 0;
+	memcpy(header + 8, &response.queueDepth, sizeof(u32));
+	memcpy(header + 12, &response.queueMicros, sizeof(u32));
+	memcpy(header + 16, &response.convertMicros, sizeof(u32));
+	memcpy(header + 20, &response.resultSize, sizeof(u64));
+	memcpy(header + 28, &messageSize, sizeof(u32));
+	
+	return SendAll(s, header, sizeof(header))
+		&& SendAll(s, response.message.data(), messageSize);
+}
+
+static bool ReceiveResponse(
+	socket_t s,
+	ServeResponse& outResponse)
+{
+	u8 header[SERVE_RESPONSE_HEADER_SIZE]{};
+	if (!RecvAll(s, header, sizeof(header))) return false;
+	
+	u32 magic{};
+	u32 messageSize{};
+	
+	memcpy(&magic, header + 0, sizeof(u32));
+	if (magic != SERVE_MAGIC) return false;
+	
+	outResponse.success = header[4] == 1;
+	memcpy(&outResponse.queueDepth, header + 8, sizeof(u32));
+	memcpy(&outResponse.queueMicros, header + 12, sizeof(u32));
+	memcpy(&outResponse.convertMicros, header + 16, sizeof(u32));
+	memcpy(&outResponse.resultSize, header + 20, sizeof(u64));
+	memcpy(&messageSize, header + 28, sizeof(u32));
+	
+	outResponse.message.resize(messageSize);
+	
+	return RecvAll(s, outResponse.message.data(), messageSize);
+}
+
+//
+// SERVER
+//
+
+//Creates the parent folders of a requested target path and checks that a kmd can be written there,
+//the extension is checked first so no folders are created for targets that would be rejected anyway
+static bool PrepareTarget(const path& target)
+{
+	if (target.extension() != ".kmd") return false;
+	
+	error_code ec{};
+	create_directories(target.parent_path(), ec);
+	
+	return Convert::IsValidTarget(target, true);
+}
+
+//Runs on a conversion thread with that thread's importer
+static void RunRequest(
+	Importer& importer,
+	const ServeRequest& request,
+	ServeResponse& response,
+	SharedSegment& outSegment)
+{
+	vector<u8> kmd{};
+	bool converted{};
+	
+	//the target is checked before converting so rejected requests never write anything
+	if (request.resultType == ServeResult::RESULT_PATH
+		&& !PrepareTarget(request.target))
+	{
+		response.message = "Target path '" + request.target + "' is not a valid kmd path!";
+		return;
+	}
+	
+	if (request.sourceType == ServeSource::SOURCE_PATH)
+	{
+		path origin(string(request.source.begin(), request.source.end()));
+		
+		if (!Convert::IsValidOrigin(origin))
+		{
+			response.message = "Origin path '" + origin.string() + "' is not a valid model!";
+			return;
+		}
+		
+		if (request.resultType == ServeResult::RESULT_PATH)
+		{
+			path target(request.target);
+			
+			response.success = Convert::ConvertFile(
+				origin,
+				target,
+				ConvertOptions
+				{
+					.scaleFactor = request.scaleFactor,
+					.threadCount = 1,
+					.importer = &importer
+				});
+				
+			error_code ec{};
+			
+			response.message = response.success
+				? target.string()
+				: "Failed to compile '" + origin.string() + "'!";
+			response.resultSize = response.success
+				? file_size(target, ec)
+				: 0;
+				
+			return;
+		}
+		
+		converted = Convert::ConvertScene(
+			origin,
+			ConvertOptions
+			{
+				.scaleFactor = request.scaleFactor,
+				.importer = &importer
+			},
+			kmd);
+	}
+	else
+	{
+		converted = Convert::ConvertScene(
+			request.source.data(),
+			request.source.size(),
+			request.extensionHint,
+			ConvertOptions
+			{
+				.scaleFactor = request.scaleFactor,
+				.importer = &importer
+			},
+			kmd);
+	}
+	
+	if (!converted)
+	{
+		response.message = "Failed to compile the requested model!";
+		return;
+	}
+	
+	response.resultSize = kmd.size();
+	
+	if (request.resultType == ServeResult::RESULT_PATH)
+	{
+		path target(request.target);
+		
+		ofstream file(target, ios::binary | ios::trunc);
+		file.write(rcast<const char*>(kmd.data()), kmd.size());
+		file.close();
+		
+		response.success = !file.fail();
+		response.message = response.success
+			? target.string()
+			: "Failed to write to target path '" + target.string() + "'!";
+			
+		return;
+	}
+	
+	if (!CreateSharedSegment(kmd, outSegment))
+	{
+		response.message = "Failed to create a shared memory segment for the compiled model!";
+		return;
+	}
+	
+	response.success = true;
+	response.message = outSegment.name;
+}
+
+//Serves requests from one client until it disconnects, segments
+//handed to this client stay alive until the connection closes
+static void RunConnection(socket_t client)
+{
+	vector<SharedSegment> segments{};
+	ServeRequest request{};
+	string rejection{};
+	
+	//allocation failures only drop this client, the server and its other clients keep running
+	try
+	{
+		while (ReceiveRequest(client, request, rejection))
+		{
+			auto received = steady_clock::now();
+			u32 queueDepth = scast<u32>(Workers::GetQueueDepth());
+			
+			ServeResponse response{};
+			SharedSegment segment{};
+			
+			promise<void> done{};
+			future<void> finished = done.get_future();
+			
+			steady_clock::time_point started{};
+			
+			Workers::Submit([&](Importer& importer)
+				{
+					started = steady_clock::now();
+					
+					//the waiting connection thread is always released and nothing escapes the worker,
+					//an exception leaving a worker thread would terminate the whole server
+					try
+					{
+						RunRequest(
+							importer,
+							request,
+							response,
+							segment);
+					}
+					catch (const bad_alloc&)
+					{
+						response.success = false;
+						response.message = "Ran out of memory while compiling the requested model!";
+					}
+					catch (...)
+					{
+						response.success = false;
+						response.message = "Failed to compile the requested model because of an unexpected error!";
+					}
+					
+					done.set_value();
+				});
+				
+			finished.wait();
+			
+			auto end = steady_clock::now();
+			
+			response.queueDepth = queueDepth;
+			response.queueMicros = scast<u32>(duration_cast<microseconds>(started - received).count());
+			response.convertMicros = scast<u32>(duration_cast<microseconds>(end - started).count());
+			
+			if (!segment.name.empty()) segments.push_back(segment);
+			
+			f64 totalMs = scast<f64>(duration_cast<microseconds>(end - received).count()) / 1000.0;
+			
+			Log::Print(
+				string(response.success ? "Served" : "Failed")
+				+ " request in " + to_string(totalMs) + " ms"
+				+ " (queue depth " + to_string(queueDepth)
+				+ ", queued " + to_string(response.queueMicros / 1000.0) + " ms"
+				+ ", compiled " + to_string(response.convertMicros / 1000.0) + " ms).",
+				"SERVE",
+				response.success ? LogType::LOG_SUCCESS : LogType::LOG_WARNING);
+				
+			if (!SendResponse(client, response)) break;
+		}
+	}
+	catch (const bad_alloc&)
+	{
+		PrintError("Closing a client connection that ran out of memory!");
+		rejection.clear();
+	}
+	
+	//the rest of a rejected request is never read, so it is answered once and the connection is closed
+	if (!rejection.empty())
+	{
+		PrintError(rejection);
+		
+		ServeResponse response{};
+		response.message = rejection;
+		
+		SendResponse(client, response);
+	}
+	
+	for (auto& s : segments) ReleaseSharedSegment(s);
+	
+	CloseSocket(client);
+}
+
+//
+// CLIENT
+//
+
+static bool SendToServer(
+	const string& socketPath,
+	const ServeRequest& request,
+	ServeResponse& outResponse,
+	vector<u8>* outSharedData)
+{
+	if (!InitSockets())
+	{
+		PrintError("Failed to initialize sockets!");
+		return false;
+	}
+	
+	sockaddr_un address{};
+	if (!MakeAddress(socketPath, address)) return false;
+	
+	socket_t s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s == INVALID_SOCKET_HANDLE)
+	{
+		PrintError("Failed to create client socket!");
+		return false;
+	}
+	
+	if (connect(s, rcast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		PrintError("Failed to connect to server at '" + socketPath + "'!");
+		
+		CloseSocket(s);
+		return false;
+	}
+	
+	auto start = steady_clock::now();
+	
+	bool received =
+		SendRequest(s, request)
+		&& ReceiveResponse(s, outResponse);
+		
+	//the segment must be read before disconnecting because the server releases it on close
+	if (received
+		&& outResponse.success
+		&& outSharedData)
+	{
+		received = ReadSharedSegment(
+			outResponse.message,
+			scast<size_t>(outResponse.resultSize),
+			*outSharedData);
+	}
+	
+	auto end = steady_clock::now();
+	
+	CloseSocket(s);
+	
+	if (!received)
+	{
+		PrintError("Failed to receive a response from server at '" + socketPath + "'!");
+		return false;
+	}
+	
+	f64 roundTripMs = scast<f64>(duration_cast<microseconds>(end - start).count()) / 1000.0;
+	
+	Log::Print(
+		"Round trip " + to_string(roundTripMs) + " ms"
+		+ " (queue depth " + to_string(outResponse.queueDepth)
+		+ ", queued " + to_string(outResponse.queueMicros / 1000.0) + " ms"
+		+ ", compiled " + to_string(outResponse.convertMicros / 1000.0) + " ms"
+		+ ", " + to_string(outResponse.resultSize) + " bytes).",
+		"SERVE",
+		LogType::LOG_INFO);
+		
+	if (!outResponse.success) PrintError(outResponse.message);
+	
+	return outResponse.success;
+}
+
+namespace KalaModel
+{
+	void Serve::Command_Serve(const vector<string>& params)
+	{
+		string socketPath = weakly_canonical(path(Core::currentDir) / params[1]).string();
+		
+		if (!InitSockets())
+		{
+			PrintError("Failed to initialize sockets!");
+			return;
+		}
+		
+		sockaddr_un address{};
+		if (!MakeAddress(socketPath, address)) return;
+		
+		//a socket file left behind by a previous server blocks bind
+		error_code ec{};
+		remove(socketPath, ec);
+		
+		socket_t server = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (server == INVALID_SOCKET_HANDLE)
+		{
+			PrintError("Failed to create server socket!");
+			return;
+		}
+		
+		if (bind(server, rcast<sockaddr*>(&address), sizeof(address)) != 0
+			|| listen(server, SOMAXCONN) != 0)
+		{
+			PrintError("Failed to listen on socket path '" + socketPath + "'!");
+			
+			CloseSocket(server);
+			return;
+		}
+		
+		Workers::Start(clamp(
+			thread::hardware_concurrency(),
+			1u,
+			MAX_SERVE_WORKERS));
+			
+		Log::Print(
+			"Serving on '" + socketPath + "' with " + to_string(Workers::GetWorkerCount()) + " conversion threads.",
+			"SERVE",
+			LogType::LOG_INFO);
+			
+		while (true)
+		{
+			socket_t client = accept(server, nullptr, nullptr);
+			if (client == INVALID_SOCKET_HANDLE) continue;
+			
+			dthread([client] { RunConnection(client); });
+		}
+	}
+	
+	void Serve::Command_SendPath(const vector<string>& params)
+	{
+		u32 scaleFactorWide = stoul(params[1]);
+		
+		ServeRequest request{};
+		request.sourceType = ServeSource::SOURCE_PATH;
+		request.resultType = ServeResult::RESULT_PATH;
+		request.scaleFactor = scast<u8>(clamp(scaleFactorWide, 0u, 8u));
+		
+		string socketPath = weakly_canonical(path(Core::currentDir) / params[2]).string();
+		string origin = weakly_canonical(path(Core::currentDir) / params[3]).string();
+		
+		request.source.assign(origin.begin(), origin.end());
+		request.target = weakly_canonical(path(Core::currentDir) / params[4]).string();
+		
+		ServeResponse response{};
+		if (!SendToServer(socketPath, request, response, nullptr)) return;
+		
+		Log::Print(
+			"Server compiled '" + origin + "' to '" + response.message + "'.",
+			"SERVE",
+			LogType::LOG_SUCCESS);
+	}
+	
+	void Serve::Command_SendBytes(const vector<string>& params)
+	{
+		u32 scaleFactorWide = stoul(params[1]);
+		
+		path origin = weakly_canonical(path(Core::currentDir) / params[3]);
+		path target = weakly_canonical(path(Core::currentDir) / params[4]);
+		
+		if (!Convert::IsValidOrigin(origin)
+			|| !Convert::IsValidTarget(target, false))
+		{
+			return;
+		}
+		
+		error_code ec{};
+		if (file_size(origin, ec) > MAX_SERVE_SOURCE_SIZE)
+		{
+			PrintError("Origin path '" + origin.string() + "' exceeds the max allowed serve source size '" + to_string(MAX_SERVE_SOURCE_SIZE) + "'!");
+			return;
+		}
+		
+		ServeRequest request{};
+		request.sourceType = ServeSource::SOURCE_BYTES;
+		request.resultType = ServeResult::RESULT_SHARED_MEMORY;
+		request.scaleFactor = scast<u8>(clamp(scaleFactorWide, 0u, 8u));
+		request.extensionHint = origin.extension().string().substr(1);
+		
+		ifstream in(origin, ios::binary);
+		request.source.assign(
+			istreambuf_iterator<char>(in),
+			istreambuf_iterator<char>());
+		in.close();
+		
+		string socketPath = weakly_canonical(path(Core::currentDir) / params[2]).string();
+		
+		ServeResponse response{};
+		vector<u8> kmd{};
+		
+		if (!SendToServer(socketPath, request, response, &kmd)) return;
+		
+		ofstream out(target, ios::binary);
+		out.write(rcast<const char*>(kmd.data()), kmd.size());
+		out.close();
+		
+		Log::Print(
+			"Server compiled '" + origin.string() + "' through shared memory '" + response.message + "' to '" + target.string() + "'.",
+			"SERVE",
+			LogType::LOG_SUCCESS);
+	}
+}
\ No newline at end of file
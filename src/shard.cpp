@@ -0,0 +1,730 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <map>
+#include <filesystem>
+#include <algorithm>
+
+//The CLI is only built on Windows, so the posix_spawn worker path has never been
+//built by CMake or run, it is only syntax checked against the glibc headers
+#ifdef _WIN32
+	#include <Windows.h>
+#elif __linux__
+	#include <spawn.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+#include "Assimp/include/Importer.hpp"
+
+#include "KalaHeaders/log_utils.hpp"
+#include "KalaHeaders/import_kmd.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "shard.hpp"
+#include "convert.hpp"
+
+#ifdef __linux__
+extern char** environ;
+#endif
+
+using Assimp::Importer;
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+using KalaHeaders::KalaModelData::ModelHeader;
+using KalaHeaders::KalaModelData::GetHeaderData;
+using KalaHeaders::KalaModelData::ImportResult;
+
+using KalaCLI::Core;
+
+using KalaModel::Shard;
+using KalaModel::Convert;
+using KalaModel::ConvertOptions;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+using std::ostringstream;
+using std::getline;
+using std::map;
+using std::sort;
+using std::min;
+using std::clamp;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::milli;
+using std::filesystem::path;
+using std::filesystem::weakly_canonical;
+using std::filesystem::create_directories;
+using std::filesystem::directory_iterator;
+using std::filesystem::is_directory;
+using std::filesystem::is_empty;
+using std::filesystem::exists;
+using std::filesystem::file_size;
+using std::filesystem::rename;
+using std::filesystem::read_symlink;
+using std::error_code;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f64 = double;
+
+//Max count of worker processes a single shard command launches
+constexpr u32 MAX_SHARD_PROCESSES = 64u;
+
+//Estimated cost of a single mesh in bytes of origin model,
+//only used when an older kmd of the same model already exists
+constexpr u64 MESH_COST = 65536u;
+
+#ifdef _WIN32
+using process_t = HANDLE;
+#else
+using process_t = pid_t;
+#endif
+
+struct ShardJob
+{
+	u8 scaleFactor{};
+	path origin{};
+	path target{};
+	u64 cost{};
+};
+
+struct ShardResult
+{
+	string name{};
+	bool success{};
+	f64 milliseconds{};
+	string worker{};
+	string origin{};
+};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"SHARD",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static path QueueDir(const path& jobDir) { return jobDir / "queue"; }
+static path ClaimedDir(const path& jobDir) { return jobDir / "claimed"; }
+static path ResultsDir(const path& jobDir) { return jobDir / "results"; }
+
+//Job name of a queued, claimed or result file, everything before the first '.' because
+//claimed files end with the worker name and hostnames can contain dots themselves
+static string JobName(const path& file)
+{
+	string name = file.filename().string();
+	return name.substr(0, name.find('.'));
+}
+
+//Origin file size plus the mesh count of the previously compiled kmd if there is one,
+//good enough to start the heaviest models first without importing anything
+static u64 EstimateCost(const ShardJob& job)
+{
+	error_code ec{};
+	u64 cost = file_size(job.origin, ec);
+	if (ec) cost = 0;
+	
+	ModelHeader header{};
+	if (exists(job.target, ec)
+		&& GetHeaderData(job.target, header) == ImportResult::RESULT_SUCCESS)
+	{
+		cost += header.modelCount * MESH_COST;
+	}
+	
+	return cost;
+}
+
+static bool ReadManifest(
+	const path& manifest,
+	vector<ShardJob>& outJobs)
+{
+	ifstream in(manifest);
+	if (!in)
+	{
+		PrintError("Failed to open manifest '" + manifest.string() + "'!");
+		return false;
+	}
+	
+	path root = manifest.parent_path();
+	string line{};
+	u32 lineNumber{};
+	
+	while (getline(in, line))
+	{
+		lineNumber++;
+		
+		if (!line.empty()
+			&& line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		
+		if (line.empty()
+			|| line[0] == '#')
+		{
+			continue;
+		}
+		
+		size_t first = line.find('\t');
+		size_t second = first == string::npos
+			? string::npos
+			: line.find('\t', first + 1);
+			
+		if (second == string::npos)
+		{
+			PrintError("Skipped manifest line '" + to_string(lineNumber) + "' because it does not have three tab-separated values!");
+			continue;
+		}
+		
+		ShardJob job{};
+		
+		try
+		{
+			job.scaleFactor = scast<u8>(clamp(stoul(line.substr(0, first)), 0ul, 8ul));
+		}
+		catch (...)
+		{
+			PrintError("Skipped manifest line '" + to_string(lineNumber) + "' because its downscale size is not a number!");
+			continue;
+		}
+		
+		job.origin = weakly_canonical(root / line.substr(first + 1, second - first - 1));
+		job.target = weakly_canonical(root / line.substr(second + 1));
+		job.cost = EstimateCost(job);
+		
+		outJobs.push_back(job);
+	}
+	
+	return true;
+}
+
+static bool WriteJob(
+	const path& file,
+	const ShardJob& job)
+{
+	ofstream out(file, ios::trunc);
+	
+	out << to_string(job.scaleFactor) << "\n"
+		<< job.origin.string() << "\n"
+		<< job.target.string() << "\n"
+		<< to_string(job.cost) << "\n";
+		
+	out.close();
+	
+	return !out.fail();
+}
+
+static bool ReadJob(
+	const path& file,
+	ShardJob& outJob)
+{
+	ifstream in(file);
+	
+	string scale{};
+	string origin{};
+	string target{};
+	string cost{};
+	
+	if (!getline(in, scale)
+		|| !getline(in, origin)
+		|| !getline(in, target))
+	{
+		return false;
+	}
+	
+	getline(in, cost);
+	
+	try
+	{
+		outJob.scaleFactor = scast<u8>(clamp(stoul(scale), 0ul, 8ul));
+		outJob.cost = cost.empty() ? 0 : stoull(cost);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	
+	outJob.origin = origin;
+	outJob.target = target;
+	
+	return true;
+}
+
+//Results are written next to the final name and renamed so readers never see half a file
+static void WriteResult(
+	const path& jobDir,
+	const ShardResult& result)
+{
+	path resultPath = ResultsDir(jobDir) / (result.name + ".result");
+	path temp = resultPath;
+	temp += ".tmp";
+	
+	ofstream out(temp, ios::trunc);
+	
+	out << (result.success ? "ok" : "failed") << "\n"
+		<< to_string(result.milliseconds) << "\n"
+		<< result.worker << "\n"
+		<< result.origin << "\n";
+		
+	out.close();
+	
+	error_code ec{};
+	rename(temp, resultPath, ec);
+}
+
+static bool ReadResult(
+	const path& file,
+	ShardResult& outResult)
+{
+	ifstream in(file);
+	
+	string status{};
+	string milliseconds{};
+	
+	if (!getline(in, status)
+		|| !getline(in, milliseconds)
+		|| !getline(in, outResult.worker)
+		|| !getline(in, outResult.origin))
+	{
+		return false;
+	}
+	
+	outResult.success = status == "ok";
+	
+	try { outResult.milliseconds = stod(milliseconds); }
+	catch (...) { outResult.milliseconds = 0; }
+	
+	return true;
+}
+
+static string GetWorkerName()
+{
+#ifdef _WIN32
+	char host[MAX_COMPUTERNAME_LENGTH + 1]{};
+	DWORD size = sizeof(host);
+	GetComputerNameA(host, &size);
+	
+	return string(host) + "-" + to_string(GetCurrentProcessId());
+#elif __linux__
+	char host[256]{};
+	gethostname(host, sizeof(host) - 1);
+	
+	return string(host) + "-" + to_string(getpid());
+#else
+	return "worker";
+#endif
+}
+
+static size_t CountQueuedJobs(const path& jobDir)
+{
+	error_code ec{};
+	size_t count{};
+	
+	for (directory_iterator it(QueueDir(jobDir), ec), end; it != end; it.increment(ec))
+	{
+		if (ec) break;
+		if (it->path().extension() == ".job") count++;
+	}
+	
+	return count;
+}
+
+//
+// WORKER PROCESSES
+//
+
+static bool SpawnWorker(
+	const path& jobDir,
+	process_t& outProcess)
+{
+#ifdef _WIN32
+	wchar_t exe[MAX_PATH]{};
+	GetModuleFileNameW(nullptr, exe, MAX_PATH);
+	
+	std::wstring commandLine =
+		L"\"" + std::wstring(exe) + L"\" --shardworker \"" + jobDir.wstring() + L"\"";
+		
+	STARTUPINFOW startup{};
+	startup.cb = sizeof(startup);
+	PROCESS_INFORMATION info{};
+	
+	if (!CreateProcessW(
+		exe,
+		commandLine.data(),
+		nullptr,
+		nullptr,
+		FALSE,
+		0,
+		nullptr,
+		nullptr,
+		&startup,
+		&info))
+	{
+		return false;
+	}
+	
+	CloseHandle(info.hThread);
+	outProcess = info.hProcess;
+	
+	return true;
+#elif __linux__
+	error_code ec{};
+	string exe = read_symlink("/proc/self/exe", ec).string();
+	if (ec) return false;
+	
+	string command = "--shardworker";
+	string dir = jobDir.string();
+	
+	char* argv[] =
+	{
+		exe.data(),
+		command.data(),
+		dir.data(),
+		nullptr
+	};
+	
+	return posix_spawn(&outProcess, exe.c_str(), nullptr, nullptr, argv, environ) == 0;
+#else
+	return false;
+#endif
+}
+
+//Blocks until one worker exits, removes it from running and returns true if it crashed
+static bool WaitForWorker(vector<process_t>& running)
+{
+#ifdef _WIN32
+	DWORD index = WaitForMultipleObjects(
+		scast<DWORD>(running.size()),
+		running.data(),
+		FALSE,
+		INFINITE);
+		
+	if (index >= WAIT_OBJECT_0 + running.size())
+	{
+		for (auto p : running) CloseHandle(p);
+		running.clear();
+		
+		return true;
+	}
+	
+	process_t process = running[index - WAIT_OBJECT_0];
+	
+	DWORD exitCode{};
+	GetExitCodeProcess(process, &exitCode);
+	CloseHandle(process);
+	
+	running.erase(running.begin() + (index - WAIT_OBJECT_0));
+	
+	return exitCode != 0;
+#elif __linux__
+	int status{};
+	pid_t pid = waitpid(-1, &status, 0);
+	
+	if (pid < 0)
+	{
+		running.clear();
+		
+		return true;
+	}
+	
+	std::erase(running, pid);
+	
+	return !WIFEXITED(status)
+		|| WEXITSTATUS(status) != 0;
+#else
+	running.clear();
+	
+	return true;
+#endif
+}
+
+//
+// SUMMARY
+//
+
+static void MergeResults(
+	const path& jobDir,
+	size_t jobCount,
+	f64 wallMilliseconds)
+{
+	vector<ShardResult> results{};
+	error_code ec{};
+	
+	for (directory_iterator it(ResultsDir(jobDir), ec), end; it != end; it.increment(ec))
+	{
+		if (ec) break;
+		if (it->path().extension() != ".result") continue;
+		
+		ShardResult r{};
+		r.name = JobName(it->path());
+		
+		if (ReadResult(it->path(), r)) results.push_back(r);
+	}
+	
+	//jobs that were claimed but never got a result took their worker down with them
+	vector<string> crashed{};
+	
+	for (directory_iterator it(ClaimedDir(jobDir), ec), end; it != end; it.increment(ec))
+	{
+		if (ec) break;
+		
+		string name = JobName(it->path());
+		if (!exists(ResultsDir(jobDir) / (name + ".result")))
+		{
+			ShardJob job{};
+			if (ReadJob(it->path(), job)) crashed.push_back(job.origin.string());
+		}
+	}
+	
+	size_t succeeded{};
+	f64 totalMilliseconds{};
+	map<string, size_t> perWorker{};
+	
+	for (const auto& r : results)
+	{
+		if (r.success) succeeded++;
+		totalMilliseconds += r.milliseconds;
+		perWorker[r.worker]++;
+	}
+	
+	sort(results.begin(), results.end(),
+		[](const ShardResult& a, const ShardResult& b) { return a.milliseconds > b.milliseconds; });
+		
+	ostringstream oss{};
+	
+	oss << "jobs:            " << jobCount << "\n"
+		<< "succeeded:       " << succeeded << "\n"
+		<< "failed:          " << results.size() - succeeded << "\n"
+		<< "crashed:         " << crashed.size() << "\n"
+		<< "not started:     " << CountQueuedJobs(jobDir) << "\n"
+		<< "wall time:       " << wallMilliseconds << " ms\n"
+		<< "compile time:    " << totalMilliseconds << " ms\n\n";
+		
+	oss << "jobs per worker:\n";
+	for (const auto& [worker, count] : perWorker) oss << "  " << worker << ": " << count << "\n";
+	
+	oss << "\nslowest jobs:\n";
+	for (size_t i = 0; i < min(results.size(), size_t{ 10 }); i++)
+	{
+		oss << "  " << results[i].milliseconds << " ms - " << results[i].origin << "\n";
+	}
+	
+	if (!crashed.empty())
+	{
+		oss << "\ncrashed jobs:\n";
+		for (const auto& c : crashed) oss << "  " << c << "\n";
+	}
+	
+	for (const auto& r : results)
+	{
+		if (!r.success) oss << "\nfailed: " << r.origin;
+	}
+	
+	ofstream out(jobDir / "summary.txt", ios::trunc);
+	out << oss.str();
+	out.close();
+	
+	Log::Print(oss.str());
+}
+
+namespace KalaModel
+{
+	void Shard::Command_Shard(const vector<string>& params)
+	{
+		path manifest = weakly_canonical(path(Core::currentDir) / params[1]);
+		path jobDir = weakly_canonical(path(Core::currentDir) / params[2]);
+		
+		u32 processCount{};
+		try
+		{
+			processCount = clamp(scast<u32>(stoul(params[3])), 1u, MAX_SHARD_PROCESSES);
+		}
+		catch (...)
+		{
+			PrintError("Failed to start shard because process count '" + params[3] + "' is not a number!");
+			return;
+		}
+		
+		vector<ShardJob> jobs{};
+		if (!ReadManifest(manifest, jobs)) return;
+		
+		if (jobs.empty())
+		{
+			PrintError("Failed to start shard because manifest '" + manifest.string() + "' has no jobs!");
+			return;
+		}
+		
+		error_code ec{};
+		
+		//job names restart from zero every run, so claims and results
+		//left behind by an earlier run would be merged into this summary
+		for (const path& dir : { QueueDir(jobDir), ClaimedDir(jobDir), ResultsDir(jobDir) })
+		{
+			if (exists(dir, ec)
+				&& !is_empty(dir, ec))
+			{
+				PrintError("Failed to start shard because job folder '" + jobDir.string() + "' still has files from an earlier run in '" + dir.filename().string() + "'!");
+				return;
+			}
+		}
+
+		create_directories(QueueDir(jobDir), ec);
+		create_directories(ClaimedDir(jobDir), ec);
+		create_directories(ResultsDir(jobDir), ec);
+		
+		//heaviest jobs are queued first so the last jobs left are the cheap ones
+		sort(jobs.begin(), jobs.end(),
+			[](const ShardJob& a, const ShardJob& b) { return a.cost > b.cost; });
+			
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			string name = to_string(i);
+			name.insert(0, 8 - min(name.size(), size_t{ 8 }), '0');
+			
+			if (!WriteJob(QueueDir(jobDir) / (name + ".job"), jobs[i]))
+			{
+				PrintError("Failed to write job '" + name + "' to job folder '" + jobDir.string() + "'!");
+				return;
+			}
+		}
+		
+		Log::Print(
+			"Queued " + to_string(jobs.size()) + " jobs to '" + jobDir.string() + "' for "
+			+ to_string(processCount) + " worker processes.",
+			"SHARD",
+			LogType::LOG_INFO);
+			
+		auto start = steady_clock::now();
+		
+		vector<process_t> running{};
+		size_t respawns{};
+		
+		for (u32 i = 0; i < processCount; i++)
+		{
+			process_t process{};
+			if (SpawnWorker(jobDir, process)) running.push_back(process);
+		}
+		
+		if (running.empty())
+		{
+			PrintError("Failed to launch any worker processes!");
+			return;
+		}
+		
+		while (!running.empty())
+		{
+			bool crashed = WaitForWorker(running);
+			
+			//replace crashed workers while there is still work left
+			if (crashed
+				&& respawns < jobs.size()
+				&& CountQueuedJobs(jobDir) > 0)
+			{
+				Log::Print(
+					"A worker process crashed, starting a new one.",
+					"SHARD",
+					LogType::LOG_WARNING);
+					
+				process_t process{};
+				if (SpawnWorker(jobDir, process)) running.push_back(process);
+				
+				respawns++;
+			}
+		}
+		
+		f64 wallMilliseconds = duration<f64, milli>(steady_clock::now() - start).count();
+		
+		MergeResults(
+			jobDir,
+			jobs.size(),
+			wallMilliseconds);
+	}
+	
+	void Shard::Command_ShardWorker(const vector<string>& params)
+	{
+		path jobDir = weakly_canonical(path(Core::currentDir) / params[1]);
+		
+		if (!is_directory(QueueDir(jobDir)))
+		{
+			PrintError("Failed to start shard worker because '" + jobDir.string() + "' is not a job folder!");
+			return;
+		}
+		
+		string worker = GetWorkerName();
+		Importer importer{};
+		
+		while (true)
+		{
+			vector<path> queued{};
+			error_code ec{};
+			
+			for (directory_iterator it(QueueDir(jobDir), ec), end; it != end; it.increment(ec))
+			{
+				if (ec) break;
+				if (it->path().extension() == ".job") queued.push_back(it->path());
+			}
+			
+			if (queued.empty()) return;
+			
+			sort(queued.begin(), queued.end());
+			
+			for (const auto& file : queued)
+			{
+				//rename is atomic on the same file system, so only one
+				//worker of any process or machine can claim each job
+				path claimed = ClaimedDir(jobDir) / (file.filename().string() + "." + worker);
+				
+				rename(file, claimed, ec);
+				if (ec) continue;
+				
+				ShardJob job{};
+				ShardResult result{};
+				result.name = JobName(file);
+				result.worker = worker;
+				
+				auto jobStart = steady_clock::now();
+				
+				if (ReadJob(claimed, job))
+				{
+					result.origin = job.origin.string();
+					
+					create_directories(job.target.parent_path(), ec);
+					
+					result.success =
+						Convert::IsValidOrigin(job.origin)
+						&& Convert::IsValidTarget(job.target, true)
+						&& Convert::ConvertFile(
+							job.origin,
+							job.target,
+							ConvertOptions
+							{
+								.scaleFactor = job.scaleFactor,
+								.threadCount = 1,
+								.importer = &importer
+							});
+				}
+				
+				result.milliseconds = duration<f64, milli>(steady_clock::now() - jobStart).count();
+				
+				WriteResult(jobDir, result);
+			}
+		}
+	}
+}
\ No newline at end of file
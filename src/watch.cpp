@@ -0,0 +1,486 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#elif __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+#include "Assimp/include/Importer.hpp"
+
+#include "KalaHeaders/log_utils.hpp"
+
+#include "KalaCLI/include/core.hpp"
+
+#include "watch.hpp"
+#include "convert.hpp"
+#include "workers.hpp"
+
+using Assimp::Importer;
+
+using KalaHeaders::KalaLog::Log;
+using KalaHeaders::KalaLog::LogType;
+
+using KalaCLI::Core;
+
+using KalaModel::Watch;
+using KalaModel::Convert;
+using KalaModel::ConvertOptions;
+using KalaModel::Workers;
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::unordered_set;
+using std::mutex;
+using std::scoped_lock;
+using std::thread;
+using std::move;
+using std::clamp;
+using std::chrono::steady_clock;
+using std::chrono::milliseconds;
+using std::chrono::duration;
+using std::milli;
+using std::filesystem::path;
+using std::filesystem::file_time_type;
+using std::filesystem::weakly_canonical;
+using std::filesystem::is_directory;
+using std::filesystem::is_regular_file;
+using std::filesystem::exists;
+using std::filesystem::last_write_time;
+using std::filesystem::create_directories;
+using std::filesystem::recursive_directory_iterator;
+using std::filesystem::directory_options;
+using std::error_code;
+
+using u8 = uint8_t;
+using u32 = uint32_t;
+using f64 = double;
+
+//How long a model must stay untouched after its last change before it is converted,
+//editors often save in several writes and we only want to convert the final one
+constexpr milliseconds DEBOUNCE_TIME{ 250 };
+
+//How long each wait for file system changes blocks before debounced models are checked again
+constexpr milliseconds POLL_TIME{ 50 };
+
+//Max count of conversion threads started by watch
+constexpr u32 MAX_WATCH_WORKERS = 4u;
+
+struct WatchJob
+{
+	path origin{};
+	path target{};
+	steady_clock::time_point changedAt{};
+};
+
+struct PendingChange
+{
+	steady_clock::time_point firstChange{};
+	steady_clock::time_point lastChange{};
+};
+
+struct Notifier
+{
+	path root{};
+
+#ifdef _WIN32
+	HANDLE handle = INVALID_HANDLE_VALUE;
+#elif __linux__
+	int fd = -1;
+	unordered_map<int, path> watchedDirs{};
+#endif
+
+	//last seen write times for platforms that only report that something changed
+	unordered_map<string, file_time_type> snapshot{};
+};
+
+//Models that are queued or being converted right now
+static mutex inFlightMutex{};
+static unordered_set<string> inFlight{};
+
+static void PrintError(const string& message)
+{
+	Log::Print(
+		message,
+		"WATCH",
+		LogType::LOG_ERROR,
+		2);
+}
+
+static path GetTargetPath(
+	const path& originRoot,
+	const path& targetRoot,
+	const path& origin)
+{
+	path target = targetRoot / origin.lexically_relative(originRoot);
+	target.replace_extension(".kmd");
+	
+	return target;
+}
+
+static bool IsModelFile(const path& file)
+{
+	error_code ec{};
+	
+	return is_regular_file(file, ec)
+		&& file.has_extension()
+		&& Convert::IsAllowedExtension(file);
+}
+
+//Collects the last write time of every model file in the origin folder
+static void TakeSnapshot(
+	const path& root,
+	unordered_map<string, file_time_type>& outSnapshot)
+{
+	error_code ec{};
+	
+	for (recursive_directory_iterator it(root, directory_options::skip_permission_denied, ec), end;
+		it != end;
+		it.increment(ec))
+	{
+		if (ec) break;
+		
+		const path& file = it->path();
+		if (!IsModelFile(file)) continue;
+		
+		outSnapshot[file.string()] = last_write_time(file, ec);
+	}
+}
+
+//Compares a fresh snapshot to the previous one and reports every new or rewritten model
+static void DiffSnapshot(
+	Notifier& notifier,
+	vector<path>& outChanged)
+{
+	unordered_map<string, file_time_type> current{};
+	TakeSnapshot(notifier.root, current);
+	
+	for (const auto& [file, time] : current)
+	{
+		auto it = notifier.snapshot.find(file);
+		if (it == notifier.snapshot.end()
+			|| it->second != time)
+		{
+			outChanged.emplace_back(file);
+		}
+	}
+	
+	notifier.snapshot = move(current);
+}
+
+//The CLI is only built on Windows, so the inotify path has never been built
+//by CMake or run, it is only syntax checked against the glibc headers
+#ifdef __linux__
+static void AddInotifyWatches(
+	Notifier& notifier,
+	const path& dir)
+{
+	constexpr u32 mask =
+		IN_CLOSE_WRITE
+		| IN_MOVED_TO
+		| IN_CREATE;
+		
+	int wd = inotify_add_watch(notifier.fd, dir.c_str(), mask);
+	if (wd >= 0) notifier.watchedDirs[wd] = dir;
+	
+	error_code ec{};
+	
+	for (recursive_directory_iterator it(dir, directory_options::skip_permission_denied, ec), end;
+		it != end;
+		it.increment(ec))
+	{
+		if (ec) break;
+		if (!it->is_directory(ec)) continue;
+		
+		wd = inotify_add_watch(notifier.fd, it->path().c_str(), mask);
+		if (wd >= 0) notifier.watchedDirs[wd] = it->path();
+	}
+}
+#endif
+
+static bool StartNotifier(Notifier& notifier)
+{
+	TakeSnapshot(notifier.root, notifier.snapshot);
+
+#ifdef _WIN32
+	notifier.handle = FindFirstChangeNotificationW(
+		notifier.root.wstring().c_str(),
+		TRUE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE
+		| FILE_NOTIFY_CHANGE_FILE_NAME
+		| FILE_NOTIFY_CHANGE_DIR_NAME);
+		
+	return notifier.handle != INVALID_HANDLE_VALUE;
+#elif __linux__
+	notifier.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifier.fd < 0) return false;
+	
+	AddInotifyWatches(notifier, notifier.root);
+	
+	return !notifier.watchedDirs.empty();
+#else
+	return true;
+#endif
+}
+
+//Blocks up to POLL_TIME and appends every file that was reported as changed
+static void WaitForChanges(
+	Notifier& notifier,
+	vector<path>& outChanged)
+{
+#ifdef _WIN32
+	DWORD result = WaitForSingleObject(
+		notifier.handle,
+		scast<DWORD>(POLL_TIME.count()));
+		
+	if (result != WAIT_OBJECT_0) return;
+	
+	//win32 change notifications only tell that something changed in the tree
+	DiffSnapshot(notifier, outChanged);
+	FindNextChangeNotification(notifier.handle);
+#elif __linux__
+	pollfd pfd
+	{
+		.fd = notifier.fd,
+		.events = POLLIN
+	};
+	
+	if (poll(&pfd, 1, scast<int>(POLL_TIME.count())) <= 0) return;
+	
+	alignas(inotify_event) char buffer[16384]{};
+	
+	while (true)
+	{
+		ssize_t length = read(notifier.fd, buffer, sizeof(buffer));
+		if (length <= 0) break;
+		
+		for (char* p = buffer; p < buffer + length;)
+		{
+			auto* e = rcast<inotify_event*>(p);
+			p += sizeof(inotify_event) + e->len;
+			
+			auto dir = notifier.watchedDirs.find(e->wd);
+			if (dir == notifier.watchedDirs.end()
+				|| e->len == 0)
+			{
+				continue;
+			}
+			
+			path file = dir->second / e->name;
+			
+			if (e->mask & IN_ISDIR)
+			{
+				//new folders are watched too, and anything copied
+				//into them before the watch existed is converted
+				AddInotifyWatches(notifier, file);
+				
+				unordered_map<string, file_time_type> added{};
+				TakeSnapshot(file, added);
+				for (const auto& [addedFile, time] : added) outChanged.emplace_back(addedFile);
+			}
+			else if (e->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) outChanged.push_back(file);
+		}
+	}
+#else
+	std::this_thread::sleep_for(POLL_TIME);
+	DiffSnapshot(notifier, outChanged);
+#endif
+}
+
+static void StopNotifier(Notifier& notifier)
+{
+#ifdef _WIN32
+	if (notifier.handle != INVALID_HANDLE_VALUE) FindCloseChangeNotification(notifier.handle);
+#elif __linux__
+	if (notifier.fd >= 0) close(notifier.fd);
+#endif
+}
+
+static void QueueConversion(
+	const WatchJob& job,
+	u8 scaleFactor)
+{
+	Workers::Submit([job, scaleFactor](Importer& importer)
+		{
+			auto convertStart = steady_clock::now();
+			
+			error_code ec{};
+			create_directories(job.target.parent_path(), ec);
+			
+			bool converted =
+				Convert::IsValidOrigin(job.origin)
+				&& Convert::IsValidTarget(job.target, true)
+				&& Convert::ConvertFile(
+					job.origin,
+					job.target,
+					ConvertOptions
+					{
+						.scaleFactor = scaleFactor,
+						.threadCount = 1,
+						.importer = &importer
+					});
+					
+			auto end = steady_clock::now();
+			
+			if (converted)
+			{
+				f64 convertMs = duration<f64, milli>(end - convertStart).count();
+				f64 totalMs = duration<f64, milli>(end - job.changedAt).count();
+				
+				Log::Print(
+					"Reconverted '" + job.origin.string() + "' in " + to_string(convertMs)
+					+ " ms (" + to_string(totalMs) + " ms from save to kmd written).",
+					"WATCH",
+					LogType::LOG_SUCCESS);
+			}
+			
+			scoped_lock lock(inFlightMutex);
+			inFlight.erase(job.origin.string());
+		});
+}
+
+namespace KalaModel
+{
+	void Watch::Command_Watch(const vector<string>& params)
+	{
+		u32 scaleFactorWide = stoul(params[1]);
+		u8 scaleFactor = scast<u8>(
+			clamp(scaleFactorWide,
+			0u,
+			8u));
+			
+		path originRoot = weakly_canonical(path(Core::currentDir) / params[2]);
+		path targetRoot = weakly_canonical(path(Core::currentDir) / params[3]);
+		
+		if (!is_directory(originRoot))
+		{
+			PrintError("Failed to start watching because origin path '" + originRoot.string() + "' is not a folder!");
+			
+			return;
+		}
+		
+		error_code ec{};
+		create_directories(targetRoot, ec);
+		if (!is_directory(targetRoot))
+		{
+			PrintError("Failed to start watching because target path '" + targetRoot.string() + "' is not a folder!");
+			
+			return;
+		}
+		
+		Notifier notifier{};
+		notifier.root = originRoot;
+		
+		if (!StartNotifier(notifier))
+		{
+			PrintError("Failed to start watching origin path '" + originRoot.string() + "'!");
+			
+			StopNotifier(notifier);
+			
+			return;
+		}
+		
+		Workers::Start(clamp(
+			thread::hardware_concurrency() / 2,
+			1u,
+			MAX_WATCH_WORKERS));
+			
+		//convert everything that has no kmd yet or has an outdated kmd
+		
+		auto now = steady_clock::now();
+		
+		for (const auto& [file, time] : notifier.snapshot)
+		{
+			path origin = file;
+			path target = GetTargetPath(originRoot, targetRoot, origin);
+			
+			if (exists(target)
+				&& last_write_time(target, ec) >= time)
+			{
+				continue;
+			}
+			
+			{
+				scoped_lock lock(inFlightMutex);
+				inFlight.insert(file);
+			}
+			
+			QueueConversion({ origin, target, now }, scaleFactor);
+		}
+		
+		Log::Print(
+			"Watching '" + originRoot.string() + "' with " + to_string(Workers::GetWorkerCount()) + " conversion threads.",
+			"WATCH",
+			LogType::LOG_INFO);
+			
+		unordered_map<string, PendingChange> pending{};
+		vector<path> changed{};
+		
+		while (true)
+		{
+			changed.clear();
+			WaitForChanges(notifier, changed);
+			
+			now = steady_clock::now();
+			
+			for (const auto& file : changed)
+			{
+				if (!file.has_extension()
+					|| !Convert::IsAllowedExtension(file))
+				{
+					continue;
+				}
+				
+				auto [it, isNew] = pending.try_emplace(file.string());
+				if (isNew) it->second.firstChange = now;
+				it->second.lastChange = now;
+			}
+			
+			if (pending.empty()) continue;
+			
+			scoped_lock lock(inFlightMutex);
+			
+			for (auto it = pending.begin(); it != pending.end();)
+			{
+				//models that are still being written to or still being
+				//converted from an earlier save stay pending
+				if (now - it->second.lastChange < DEBOUNCE_TIME
+					|| inFlight.contains(it->first))
+				{
+					++it;
+					continue;
+				}
+				
+				path origin = it->first;
+				
+				inFlight.insert(it->first);
+				QueueConversion(
+				{
+					.origin = origin,
+					.target = GetTargetPath(originRoot, targetRoot, origin),
+					.changedAt = it->second.firstChange
+				},
+				scaleFactor);
+				
+				it = pending.erase(it);
+			}
+		}
+	}
+}
\ No newline at end of file
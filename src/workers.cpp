@@ -0,0 +1,94 @@
+//Copyright(C) 2025 Lost Empire Entertainment
+//This program comes with ABSOLUTELY NO WARRANTY.
+//This is free software, and you are welcome to redistribute it under certain conditions.
+//Read LICENSE.md for more information.
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+#include "Assimp/include/Importer.hpp"
+
+#include "KalaHeaders/thread_utils.hpp"
+
+#include "workers.hpp"
+
+using Assimp::Importer;
+
+using KalaHeaders::KalaThread::dthread;
+
+using std::deque;
+using std::mutex;
+using std::scoped_lock;
+using std::unique_lock;
+using std::condition_variable;
+using std::move;
+using std::function;
+
+using u32 = uint32_t;
+
+static mutex queueMutex{};
+static condition_variable queueCondition{};
+static deque<function<void(Importer&)>> jobs{};
+static u32 workerCount{};
+
+static void RunWorker()
+{
+	Importer importer{};
+	
+	while (true)
+	{
+		function<void(Importer&)> job{};
+		
+		{
+			unique_lock lock(queueMutex);
+			queueCondition.wait(lock, [] { return !jobs.empty(); });
+			
+			job = move(jobs.front());
+			jobs.pop_front();
+		}
+		
+		job(importer);
+		
+		//release the last scene so idle threads don't hold on to it
+		importer.FreeScene();
+	}
+}
+
+namespace KalaModel
+{
+	void Workers::Start(u32 count)
+	{
+		scoped_lock lock(queueMutex);
+		
+		if (workerCount > 0) return;
+		
+		workerCount = count > 0 ? count : 1;
+		
+		//conversion threads live until the process exits
+		for (u32 i = 0; i < workerCount; i++) dthread(RunWorker);
+	}
+	
+	void Workers::Submit(function<void(Importer&)> job)
+	{
+		{
+			scoped_lock lock(queueMutex);
+			jobs.push_back(move(job));
+		}
+		
+		queueCondition.notify_one();
+	}
+	
+	size_t Workers::GetQueueDepth()
+	{
+		scoped_lock lock(queueMutex);
+		return jobs.size();
+	}
+	
+	u32 Workers::GetWorkerCount()
+	{
+		scoped_lock lock(queueMutex);
+		return workerCount;
+	}
+}
\ No newline at end of file